@@ -0,0 +1,54 @@
+// BazPOBenchmark.cpp : Measures registration and tryParse throughput with valid and invalid arguments.
+//
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/BazPO.hpp"
+using namespace BazPO;
+
+namespace
+{
+    const int OptionCount = 64;
+    const int Iterations = 20000;
+
+    std::vector<std::string> makeArguments(bool invalid)
+    {
+        std::vector<std::string> arguments{ "benchmark" };
+        for (int i = 0; i < OptionCount; ++i)
+        {
+            arguments.push_back("--option" + std::to_string(i));
+            arguments.push_back(invalid && i % 2 == 0 ? "not-a-number" : std::to_string(i));
+        }
+        if (invalid)
+            arguments.push_back("unexpected");
+        return arguments;
+    }
+
+    void run(const char* name, bool invalid)
+    {
+        auto arguments = makeArguments(invalid);
+        std::vector<const char*> argv;
+        for (const auto& argument : arguments)
+            argv.push_back(argument.c_str());
+
+        size_t diagnostics = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int iteration = 0; iteration < Iterations; ++iteration)
+        {
+            Cli po{ static_cast<int>(argv.size()), argv.data() };
+            for (int i = 0; i < OptionCount; ++i)
+                po.typedOption<int>("--option" + std::to_string(i));
+            diagnostics += po.tryParse().diagnostics().size();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << name << ": " << elapsed / Iterations << " ns per parse, " << diagnostics / Iterations << " diagnostics per parse" << std::endl;
+    }
+}
+
+int main()
+{
+    run("valid arguments", false);
+    run("invalid arguments", true);
+}
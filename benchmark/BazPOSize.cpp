@@ -0,0 +1,20 @@
+// BazPOSize.cpp : Small helper program, built normally and with BazPO_LEAN to compare binary size and startup time.
+//
+
+#include <cstdio>
+#include "../include/BazPO.hpp"
+using namespace BazPO;
+
+int main(int argc, const char* argv[])
+{
+    Cli po{ argc, argv, "Copies blocks of a file" };
+    ValueOption input(&po, "-i", "--input", "Input file", "", true);
+    ValueOption output(&po, "-o", "--output", "Output file", "out.bin");
+    TypedOption<int> blockSize(&po, "-b", "--block-size", "Block size", 4096);
+    FlagOption verbose(&po, "-v", "Print progress", "--verbose");
+    po.parse();
+
+    if (verbose.exists())
+        std::printf("%s -> %s in blocks of %d\n", input.value(), output.value(), blockSize.get());
+    return 0;
+}
@@ -0,0 +1,265 @@
+#ifndef BAZ_PO_ASYNC_HPP
+#define BAZ_PO_ASYNC_HPP
+
+/*
+BazPO asynchronous option functions.
+Copyright (c) 2022 Baris Tanyeri
+https://github.com/karusb/BazPO
+MIT License
+*/
+
+#include "../BazPO.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#error "BazPO/Async.hpp requires POSIX poll()"
+#endif
+#include <poll.h>
+
+#if defined(__has_include)
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#define BazPO_HAS_COROUTINES
+#include <coroutine>
+#endif
+#endif
+
+namespace BazPO
+{
+#ifdef BazPO_HAS_COROUTINES
+    // Coroutine returned by asynchronous option functions, runs until its first suspension when created
+    class Task
+    {
+    public:
+        struct promise_type
+        {
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { error = std::current_exception(); }
+
+            std::exception_ptr error;
+        };
+
+        Task(const Task&) = delete;
+        Task(Task&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+        ~Task()
+        {
+            if (handle)
+                handle.destroy();
+        }
+
+        inline bool done() const { return !handle || handle.done(); }
+        inline void rethrow() const
+        {
+            if (handle && handle.promise().error)
+                std::rethrow_exception(handle.promise().error);
+        }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+        std::coroutine_handle<promise_type> handle;
+    };
+    using AsyncFunction = std::function<Task(const Option&)>;
+#else
+    // Without coroutine support asynchronous option functions are executed as blocking functions
+    using AsyncFunction = std::function<void(const Option&)>;
+#endif
+
+    // Single threaded poll() loop driving the asynchronous option functions.
+    // Functions may be started from the threads of a parallel callback executor, they continue on the thread running the loop.
+    // With coroutines: co_await loop.readable(fd), co_await loop.writable(fd), co_await loop.sleepFor(duration)
+    // Without coroutines the same calls block: loop.readable(fd).wait()
+    class EventLoop
+    {
+    public:
+        class Wait
+        {
+        public:
+            Wait(EventLoop& loop, int fd, short events, std::chrono::steady_clock::time_point deadline) : loop(loop), fd(fd), events(events), deadline(deadline) {}
+#ifdef BazPO_HAS_COROUTINES
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { loop.suspend({ fd, events, deadline, handle }); }
+            void await_resume() const noexcept {}
+#endif
+            // Blocks until the wait is over
+            void wait() const
+            {
+                pollfd descriptor{ fd, events, 0 };
+                for (;;)
+                {
+                    int timeout = fd < 0 ? 0 : -1;
+                    if (fd < 0)
+                    {
+                        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                        if (remaining <= 0)
+                            return;
+                        timeout = static_cast<int>(remaining);
+                    }
+                    if (::poll(fd < 0 ? nullptr : &descriptor, fd < 0 ? 0 : 1, timeout) > 0)
+                        return;
+                }
+            }
+        private:
+            EventLoop& loop;
+            int fd;
+            short events;
+            std::chrono::steady_clock::time_point deadline;
+        };
+
+        EventLoop() = default;
+        EventLoop(const EventLoop&) = delete;
+
+        inline Wait readable(int fd) { return { *this, fd, POLLIN, std::chrono::steady_clock::time_point::max() }; }
+        inline Wait writable(int fd) { return { *this, fd, POLLOUT, std::chrono::steady_clock::time_point::max() }; }
+        template <typename Rep, typename Period>
+        inline Wait sleepFor(std::chrono::duration<Rep, Period> duration) { return { *this, -1, 0, std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration) }; }
+
+#ifdef BazPO_HAS_COROUTINES
+        inline void spawn(Task task)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace_back(std::move(task));
+        }
+#endif
+
+        // Runs until every asynchronous function finished, the first exception in execution order is rethrown
+        void run()
+        {
+#ifdef BazPO_HAS_COROUTINES
+            std::vector<pollfd> descriptors;
+            std::vector<std::coroutine_handle<>> resumable;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!waits.empty())
+            {
+                auto now = std::chrono::steady_clock::now();
+                auto deadline = std::chrono::steady_clock::time_point::max();
+                descriptors.clear();
+                for (const auto& wait : waits)
+                {
+                    deadline = std::min(deadline, wait.deadline);
+                    if (wait.fd >= 0)
+                        descriptors.push_back({ wait.fd, wait.events, 0 });
+                }
+                lock.unlock();
+                int timeout = -1;
+                if (deadline != std::chrono::steady_clock::time_point::max())
+                    timeout = static_cast<int>(std::max<long long>(0, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now + std::chrono::microseconds(999)).count()));
+                if (::poll(descriptors.data(), descriptors.size(), timeout) < 0 && errno != EINTR)
+                    throw std::runtime_error("poll failed");
+
+                now = std::chrono::steady_clock::now();
+                resumable.clear();
+                lock.lock();
+                size_t descriptor = 0;
+                for (auto wait = waits.begin(); wait != waits.end();)
+                {
+                    bool ready = wait->fd >= 0 ? descriptors[descriptor++].revents != 0 : wait->deadline <= now;
+                    if (ready)
+                    {
+                        resumable.push_back(wait->handle);
+                        wait = waits.erase(wait);
+                    }
+                    else
+                        ++wait;
+                }
+                // Resumed functions may wait again
+                lock.unlock();
+                for (auto handle : resumable)
+                    handle.resume();
+                lock.lock();
+            }
+            auto finished = std::move(tasks);
+            tasks.clear();
+            lock.unlock();
+            for (const auto& task : finished)
+                task.rethrow();
+#endif
+        }
+
+    private:
+#ifdef BazPO_HAS_COROUTINES
+        struct Waiting
+        {
+            int fd;
+            short events;
+            std::chrono::steady_clock::time_point deadline;
+            std::coroutine_handle<> handle;
+        };
+        inline void suspend(const Waiting& wait)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            waits.push_back(wait);
+        }
+
+        // Functions are started and suspended concurrently by parallel callback executors
+        std::mutex mutex;
+        std::vector<Waiting> waits;
+        std::vector<Task> tasks;
+#endif
+    };
+
+    namespace _detail
+    {
+        class AsyncFunctionExecutor
+        {
+        public:
+            AsyncFunctionExecutor(EventLoop& loop, const AsyncFunction& onExists)
+                : loop(loop)
+                , f(onExists)
+            {}
+        protected:
+            void start(const Option& option) const
+            {
+#ifdef BazPO_HAS_COROUTINES
+                loop.spawn(f(option));
+#else
+                f(option);
+#endif
+            }
+
+            EventLoop& loop;
+            AsyncFunction f;
+        };
+    }
+
+    // Function is started after parsing and continues on the event loop whenever it waits
+    class AsyncFunctionOption
+        : public ValueOption
+        , protected _detail::AsyncFunctionExecutor
+    {
+    public:
+        AsyncFunctionOption(ICli* po, EventLoop& loop, _detail::StringRef parameter, const AsyncFunction& onExists, _detail::StringRef secondParameter = "", _detail::StringRef description = "", _detail::StringRef defaultValue = "", bool mandatory = false, size_t maxValueCount = SIZE_MAX)
+            : ValueOption(po, parameter, secondParameter, description, defaultValue, mandatory, maxValueCount)
+            , _detail::AsyncFunctionExecutor(loop, onExists)
+        {}
+        virtual void execute(const Option& option) const override { start(option); }
+    };
+
+    class AsyncFunctionFlag
+        : public FlagOption
+        , protected _detail::AsyncFunctionExecutor
+    {
+    public:
+        AsyncFunctionFlag(ICli* po, EventLoop& loop, _detail::StringRef parameter, const AsyncFunction& onExists, _detail::StringRef description = "", _detail::StringRef secondParameter = "", bool mandatory = false)
+            : FlagOption(po, parameter, description, secondParameter, mandatory)
+            , _detail::AsyncFunctionExecutor(loop, onExists)
+        {}
+        virtual void execute(const Option& option) const override { start(option); }
+    };
+
+    // Parses the arguments, then drives the asynchronous option functions until all of them finished
+    inline void parseAsync(Cli& cli, EventLoop& loop)
+    {
+        cli.parse();
+        loop.run();
+    }
+}
+
+#endif
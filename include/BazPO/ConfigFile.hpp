@@ -0,0 +1,312 @@
+#ifndef BAZ_PO_CONFIG_FILE_HPP
+#define BAZ_PO_CONFIG_FILE_HPP
+
+/*
+BazPO configuration file source.
+Copyright (c) 2022 Baris Tanyeri
+https://github.com/karusb/BazPO
+MIT License
+*/
+
+#include "../BazPO.hpp"
+#include <climits>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <tuple>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace BazPO
+{
+    namespace _detail
+    {
+        class ConfigFileError
+            : public std::exception
+        {
+        public:
+            explicit ConfigFileError(const std::string& message) : err(message) {}
+            const char* what() const noexcept override { return err.c_str(); };
+        private:
+            std::string err;
+        };
+
+        // Read only view of a file. Files up to ReadLimit are read into a buffer, larger files are mapped and never copied:
+        // truncating or rewriting a mapped file in place makes reading it fail with SIGBUS.
+        // Replace large configuration files by renaming a new file over them.
+        class MappedFile
+        {
+        public:
+            // Files within a page gain nothing from a mapping
+            static const size_t ReadLimit = 4 * 1024;
+
+            explicit MappedFile(const std::string& path)
+            {
+#if defined(_WIN32)
+                std::ifstream file(path, std::ios::binary);
+                if (!file)
+                    BazPO_THROW(ConfigFileError("Unable to open configuration file " + path));
+                buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                data = buffer.data();
+                size = buffer.size();
+#else
+                int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0)
+                    BazPO_THROW(ConfigFileError("Unable to open configuration file " + path));
+                struct stat st;
+                if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+                {
+                    ::close(fd);
+                    BazPO_THROW(ConfigFileError("Configuration file is not a regular file " + path));
+                }
+                size = static_cast<size_t>(st.st_size);
+                if (size > 0 && size <= ReadLimit)
+                {
+                    buffer.resize(size);
+                    size_t read = 0;
+                    while (read < size)
+                    {
+                        auto count = ::read(fd, buffer.data() + read, size - read);
+                        if (count < 0 && errno == EINTR)
+                            continue;
+                        if (count <= 0)
+                            break;
+                        read += static_cast<size_t>(count);
+                    }
+                    // A file truncated while reading ends early
+                    size = read;
+                    data = buffer.data();
+                }
+                else if (size > 0)
+                {
+                    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (mapping == MAP_FAILED)
+                    {
+                        ::close(fd);
+                        BazPO_THROW(ConfigFileError("Unable to map configuration file " + path));
+                    }
+                    ::madvise(mapping, size, MADV_SEQUENTIAL);
+                    data = static_cast<const char*>(mapping);
+                }
+                ::close(fd);
+#endif
+            }
+            MappedFile(const MappedFile&) = delete;
+            ~MappedFile()
+            {
+#if !defined(_WIN32)
+                if (data != nullptr && buffer.empty())
+                    ::munmap(const_cast<char*>(data), size);
+#endif
+            }
+
+            const char* data = nullptr;
+            size_t size = 0;
+        private:
+            std::vector<char> buffer;
+        };
+
+        struct FileIdentity
+        {
+            std::string path;
+            long long modified = 0;
+            long long size = 0;
+
+            bool operator<(const FileIdentity& other) const { return std::tie(path, modified, size) < std::tie(other.path, other.modified, other.size); }
+        };
+
+        inline FileIdentity identifyFile(const std::string& path)
+        {
+            FileIdentity identity;
+#if defined(_WIN32)
+            identity.path = path;
+#else
+            char resolved[PATH_MAX];
+            identity.path = ::realpath(path.c_str(), resolved) != nullptr ? resolved : path;
+            struct stat st;
+            if (::stat(identity.path.c_str(), &st) == 0)
+            {
+#if defined(__APPLE__)
+                identity.modified = static_cast<long long>(st.st_mtimespec.tv_sec) * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+                identity.modified = static_cast<long long>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+                identity.size = static_cast<long long>(st.st_size);
+            }
+#endif
+            return identity;
+        }
+    }
+
+    // INI style configuration file, sections, keys and values are views into the file that are not null terminated.
+    // key = value              -> key
+    // [section]                -> section.key for the keys below
+    // @include other.conf      -> entries of other.conf, relative to the including file
+    // # comment / ; comment
+    class ConfigFile
+        : public OptionSource
+    {
+    public:
+        // Loads the file once per process, until the file is modified or the cache is cleared
+        static std::shared_ptr<const ConfigFile> load(const std::string& path)
+        {
+            auto identity = _detail::identifyFile(path);
+            std::lock_guard<std::recursive_mutex> lock(cacheMutex());
+            auto& cache = loadedFiles();
+            auto cached = cache.find(identity);
+            if (cached != cache.end())
+                return cached->second;
+
+            auto& loading = loadingFiles();
+            if (!loading.insert(identity.path).second)
+                BazPO_THROW(_detail::ConfigFileError("Configuration file includes itself " + identity.path));
+            std::shared_ptr<const ConfigFile> file;
+#ifdef BazPO_DISABLE_EXCEPTIONS
+            file = std::shared_ptr<const ConfigFile>(new ConfigFile(identity.path));
+#else
+            // Files that failed to load can be loaded again
+            try
+            {
+                file = std::shared_ptr<const ConfigFile>(new ConfigFile(identity.path));
+            }
+            catch (...)
+            {
+                loading.erase(identity.path);
+                throw;
+            }
+#endif
+            loading.erase(identity.path);
+            // A modified file replaces its previous version, views of the previous version live as long as their sources
+            auto previous = cache.lower_bound({ identity.path, LLONG_MIN, LLONG_MIN });
+            while (previous != cache.end() && previous->first.path == identity.path)
+                previous = cache.erase(previous);
+            return cache.emplace(identity, file).first->second;
+        }
+        static void clearCache()
+        {
+            std::lock_guard<std::recursive_mutex> lock(cacheMutex());
+            loadedFiles().clear();
+        }
+
+        virtual const std::vector<Entry>& entries() const override { return m_entries; }
+        const std::string& path() const { return m_path; }
+
+    private:
+        explicit ConfigFile(const std::string& path)
+            : m_path(path)
+            , m_file(path)
+        {
+            parse();
+        }
+
+        static std::recursive_mutex& cacheMutex() { static std::recursive_mutex mutex; return mutex; }
+        static std::map<_detail::FileIdentity, std::shared_ptr<const ConfigFile>>& loadedFiles() { static std::map<_detail::FileIdentity, std::shared_ptr<const ConfigFile>> files; return files; }
+        static std::set<std::string>& loadingFiles() { static std::set<std::string> files; return files; }
+        static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v'; }
+
+        void parse()
+        {
+            const char* const begin = m_file.data;
+            const char* const end = begin + m_file.size;
+            _detail::StringRef section;
+            for (const char* line = begin; line < end;)
+            {
+                const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+                if (lineEnd == nullptr)
+                    lineEnd = end;
+
+                const char* first = line;
+                while (first < lineEnd && isSpace(*first))
+                    ++first;
+                const char* last = lineEnd;
+                while (last > first && isSpace(*(last - 1)))
+                    --last;
+
+                if (first == last || *first == '#' || *first == ';')
+                {
+                    line = lineEnd + 1;
+                    continue;
+                }
+                if (*first == '[')
+                    section = parseSection(first, last);
+                else if (*first == '@')
+                    include(first, last);
+                else
+                    parseValue(section, first, last);
+
+                line = lineEnd + 1;
+            }
+        }
+
+        static _detail::StringRef view(const char* first, const char* last) { return { first, static_cast<size_t>(last - first), false }; }
+
+        _detail::StringRef parseSection(const char* first, const char* last)
+        {
+            const char* close = static_cast<const char*>(std::memchr(first, ']', static_cast<size_t>(last - first)));
+            if (close == nullptr)
+                BazPO_THROW(_detail::ConfigFileError("Unterminated section '" + std::string(first, last) + "' in " + m_path));
+            ++first;
+            while (first < close && isSpace(*first))
+                ++first;
+            const char* sectionEnd = close;
+            while (sectionEnd > first && isSpace(*(sectionEnd - 1)))
+                --sectionEnd;
+            return view(first, sectionEnd);
+        }
+
+        void parseValue(_detail::StringRef section, const char* first, const char* last)
+        {
+            const char* equals = static_cast<const char*>(std::memchr(first, '=', static_cast<size_t>(last - first)));
+            const char* keyEnd = equals != nullptr ? equals : last;
+            while (keyEnd > first && isSpace(*(keyEnd - 1)))
+                --keyEnd;
+
+            const char* value = equals != nullptr ? equals + 1 : last;
+            while (value < last && isSpace(*value))
+                ++value;
+            if (last - value >= 2 && (*value == '"' || *value == '\'') && *(last - 1) == *value)
+            {
+                ++value;
+                --last;
+            }
+            m_entries.push_back({ section, view(first, keyEnd), view(value, last) });
+        }
+
+        void include(const char* first, const char* last)
+        {
+            static const char directive[] = "@include";
+            const size_t directiveSize = sizeof(directive) - 1;
+            if (static_cast<size_t>(last - first) <= directiveSize || std::strncmp(first, directive, directiveSize) != 0 || !isSpace(first[directiveSize]))
+                BazPO_THROW(_detail::ConfigFileError("Unknown directive '" + std::string(first, last) + "' in " + m_path));
+
+            first += directiveSize;
+            while (first < last && isSpace(*first))
+                ++first;
+            std::string path(first, last);
+            if (path.front() != '/' && path.front() != '\\')
+            {
+                auto directoryEnd = m_path.find_last_of("/\\");
+                if (directoryEnd != std::string::npos)
+                    path.insert(0, m_path.substr(0, directoryEnd + 1));
+            }
+            m_includes.emplace_back(load(path));
+            m_entries.insert(m_entries.end(), m_includes.back()->entries().begin(), m_includes.back()->entries().end());
+        }
+
+        std::string m_path;
+        _detail::MappedFile m_file;
+        std::vector<Entry> m_entries;
+        std::deque<std::shared_ptr<const ConfigFile>> m_includes;
+    };
+}
+
+#endif
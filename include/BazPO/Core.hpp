@@ -0,0 +1,2413 @@
+#ifndef BAZ_PO_CORE_HPP
+#define BAZ_PO_CORE_HPP
+
+/*
+BazPO declarations, options and the Cli without the parser definitions.
+Copyright (c) 2022 Baris Tanyeri
+https://github.com/karusb/BazPO
+MIT License
+*/
+
+#include <string>
+#include <map>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <cstddef>
+#include <exception>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <limits>
+#include <chrono>
+#include <mutex>
+
+// Lean build for small binaries: no iostream, no exceptions
+#ifdef BazPO_LEAN
+#ifndef BazPO_DISABLE_IOSTREAM
+#define BazPO_DISABLE_IOSTREAM
+#endif
+#ifndef BazPO_DISABLE_EXCEPTIONS
+#define BazPO_DISABLE_EXCEPTIONS
+#endif
+#endif
+
+#ifndef BazPO_DISABLE_IOSTREAM
+#include <sstream>
+#include <iostream>
+#endif
+
+// Programming errors abort with the message of the error when exceptions are disabled
+#ifdef BazPO_DISABLE_EXCEPTIONS
+#define BazPO_THROW(error) (std::fputs(static_cast<const std::exception&>(error).what(), stderr), std::fputc('\n', stderr), std::abort())
+#else
+#define BazPO_THROW(error) throw error
+#endif
+
+namespace BazPO
+{
+    class Option;
+    class Constraint;
+    class MultiConstraint;
+    class CallbackExecutor;
+    struct Diagnostic;
+    // Receives the printed text instead of a stream
+    using WriteFunction = void (*)(void* context, const char* data, size_t size);
+    // Reads a line without the line ending, returns false at the end of the input
+    using ReadLineFunction = bool (*)(void* context, std::string& line);
+    namespace _detail
+    {
+        class Serializer;
+        class RegistrationTimer;
+
+        // View of a null terminated string, persistent views outlive the options referring to them
+        class StringRef
+        {
+        public:
+            constexpr StringRef() = default;
+            StringRef(const char* text) : m_data(text), m_size(std::strlen(text)), m_persistent(false) {}
+            StringRef(const std::string& text) : m_data(text.c_str()), m_size(text.size()), m_persistent(false) {}
+            constexpr StringRef(const char* text, size_t size, bool persistent) : m_data(text), m_size(size), m_persistent(persistent) {}
+
+            inline const char* c_str() const { return m_data; }
+            inline size_t size() const { return m_size; }
+            inline bool empty() const { return m_size == 0; }
+            inline bool persistent() const { return m_persistent; }
+            inline std::string str() const { return std::string(m_data, m_size); }
+            operator std::string() const { return str(); }
+
+            friend bool operator==(const StringRef& lhs, const StringRef& rhs) { return lhs.m_size == rhs.m_size && std::memcmp(lhs.m_data, rhs.m_data, lhs.m_size) == 0; }
+            friend bool operator!=(const StringRef& lhs, const StringRef& rhs) { return !(lhs == rhs); }
+            friend bool operator<(const StringRef& lhs, const StringRef& rhs)
+            {
+                int result = std::memcmp(lhs.m_data, rhs.m_data, std::min(lhs.m_size, rhs.m_size));
+                return result != 0 ? result < 0 : lhs.m_size < rhs.m_size;
+            }
+#ifndef BazPO_DISABLE_IOSTREAM
+            friend std::ostream& operator<<(std::ostream& stream, const StringRef& text) { return stream.write(text.m_data, static_cast<std::streamsize>(text.m_size)); }
+#endif
+
+        private:
+            const char* m_data = "";
+            size_t m_size = 0;
+            bool m_persistent = true;
+        };
+
+        // Copies strings into shared blocks once, equal strings are stored once
+        class StringPool
+        {
+        public:
+            StringPool() = default;
+            StringPool(const StringPool&) = delete;
+
+            StringRef intern(StringRef text)
+            {
+                if (text.persistent())
+                    return text;
+                if (text.empty())
+                    return StringRef();
+                if ((m_count + 1) * 2 > m_slots.size())
+                    grow();
+                size_t mask = m_slots.size() - 1;
+                for (size_t i = hash(text) & mask;; i = (i + 1) & mask)
+                {
+                    if (m_slots[i].c_str() == nullptr)
+                    {
+                        ++m_count;
+                        return m_slots[i] = copy(text);
+                    }
+                    if (m_slots[i] == text)
+                        return m_slots[i];
+                }
+            }
+
+        private:
+            static const size_t BlockSize = 8192;
+
+            static size_t hash(StringRef text)
+            {
+                size_t value = static_cast<size_t>(14695981039346656037ULL);
+                for (size_t i = 0; i < text.size(); ++i)
+                    value = (value ^ static_cast<unsigned char>(text.c_str()[i])) * static_cast<size_t>(1099511628211ULL);
+                return value;
+            }
+            void grow()
+            {
+                std::vector<StringRef> slots(m_slots.empty() ? 64 : m_slots.size() * 2, StringRef(nullptr, 0, false));
+                size_t mask = slots.size() - 1;
+                for (const auto& slot : m_slots)
+                {
+                    if (slot.c_str() == nullptr)
+                        continue;
+                    size_t i = hash(slot) & mask;
+                    while (slots[i].c_str() != nullptr)
+                        i = (i + 1) & mask;
+                    slots[i] = slot;
+                }
+                m_slots.swap(slots);
+            }
+            StringRef copy(StringRef text)
+            {
+                const size_t size = text.size() + 1;
+                char* destination;
+                // Large strings get their own block, the current block keeps filling
+                if (size > BlockSize / 4)
+                {
+                    m_blocks.emplace_back(new char[size]);
+                    destination = m_blocks.back().get();
+                }
+                else
+                {
+                    if (m_current == nullptr || BlockSize - m_used < size)
+                    {
+                        m_blocks.emplace_back(new char[BlockSize]);
+                        m_current = m_blocks.back().get();
+                        m_used = 0;
+                    }
+                    destination = m_current + m_used;
+                    m_used += size;
+                }
+                // Views need not be null terminated
+                std::memcpy(destination, text.c_str(), text.size());
+                destination[text.size()] = '\0';
+                return StringRef(destination, text.size(), true);
+            }
+
+            std::vector<std::unique_ptr<char[]>> m_blocks;
+            char* m_current = nullptr;
+            size_t m_used = 0;
+            std::vector<StringRef> m_slots;
+            size_t m_count = 0;
+        };
+
+        // Trie of the sorted long option names in flat arrays, every node covers the range of names starting with its prefix.
+        // Nodes are split only while the range has more than one name, the rest of a unique name is compared directly.
+        // Finding a prefix visits one node per character, independent of the number of options.
+        class PrefixIndex
+        {
+        public:
+            struct Name
+            {
+                StringRef name;
+                Option* option;
+            };
+
+            void build(std::vector<Name> names)
+            {
+                std::sort(names.begin(), names.end(), [](const Name& l, const Name& r) { return l.name < r.name; });
+                m_names.swap(names);
+                m_nodes.clear();
+                m_edges.clear();
+                if (!m_names.empty())
+                    addNode(0, m_names.size(), 0);
+            }
+
+            // Names starting with the prefix as a range of names(), empty when there are none
+            std::pair<size_t, size_t> find(StringRef prefix) const
+            {
+                if (m_nodes.empty())
+                    return { 0, 0 };
+                size_t node = 0;
+                for (size_t depth = 0; depth < prefix.size(); ++depth)
+                {
+                    const auto& current = m_nodes[node];
+                    if (current.last - current.first == 1)
+                    {
+                        const auto& name = m_names[current.first].name;
+                        if (name.size() < prefix.size() || std::memcmp(name.c_str() + depth, prefix.c_str() + depth, prefix.size() - depth) != 0)
+                            return { 0, 0 };
+                        return { current.first, current.last };
+                    }
+                    auto begin = m_edges.begin() + current.firstEdge;
+                    auto end = begin + current.edgeCount;
+                    const auto label = static_cast<unsigned char>(prefix.c_str()[depth]);
+                    auto edge = std::lower_bound(begin, end, label, [](const Edge& e, unsigned char l) { return e.label < l; });
+                    if (edge == end || edge->label != label)
+                        return { 0, 0 };
+                    node = edge->node;
+                }
+                return { m_nodes[node].first, m_nodes[node].last };
+            }
+            // Option of every name in the range, null when the names belong to different options
+            Option* option(std::pair<size_t, size_t> range) const
+            {
+                if (range.first == range.second)
+                    return nullptr;
+                for (size_t i = range.first + 1; i < range.second; ++i)
+                    if (m_names[i].option != m_names[range.first].option)
+                        return nullptr;
+                return m_names[range.first].option;
+            }
+            inline const std::vector<Name>& names() const { return m_names; }
+
+        private:
+            struct Node
+            {
+                size_t first;
+                size_t last;
+                size_t firstEdge;
+                size_t edgeCount;
+            };
+            struct Edge
+            {
+                unsigned char label;
+                size_t node;
+            };
+
+            size_t addNode(size_t first, size_t last, size_t depth)
+            {
+                const size_t node = m_nodes.size();
+                m_nodes.push_back({ first, last, 0, 0 });
+                if (last - first == 1)
+                    return node;
+                // Names ending at this depth sort first, the rest are grouped by their next character
+                while (first < last && m_names[first].name.size() == depth)
+                    ++first;
+                std::vector<std::pair<unsigned char, size_t>> groups;
+                for (size_t i = first; i < last; ++i)
+                {
+                    const auto label = static_cast<unsigned char>(m_names[i].name.c_str()[depth]);
+                    if (groups.empty() || groups.back().first != label)
+                        groups.emplace_back(label, i);
+                }
+                m_nodes[node].firstEdge = m_edges.size();
+                m_nodes[node].edgeCount = groups.size();
+                m_edges.resize(m_edges.size() + groups.size());
+                for (size_t i = 0; i < groups.size(); ++i)
+                {
+                    size_t groupLast = i + 1 < groups.size() ? groups[i + 1].second : last;
+                    size_t child = addNode(groups[i].second, groupLast, depth + 1);
+                    m_edges[m_nodes[node].firstEdge + i] = { groups[i].first, child };
+                }
+                return node;
+            }
+
+            std::vector<Name> m_names;
+            std::vector<Node> m_nodes;
+            std::vector<Edge> m_edges;
+        };
+
+        // Printed text goes to the write function when one is given, otherwise to the output stream
+        class Output
+        {
+        public:
+            static void writeStandardOutput(void*, const char* data, size_t size) { std::fwrite(data, 1, size, stdout); }
+
+            inline void redirect(WriteFunction write, void* context) { m_write = write; m_context = context; }
+#ifndef BazPO_DISABLE_IOSTREAM
+            inline void redirect(std::ostream* stream) { m_stream = stream; m_write = nullptr; }
+#endif
+            void write(const char* data, size_t size)
+            {
+#ifndef BazPO_DISABLE_IOSTREAM
+                if (m_write == nullptr)
+                {
+                    m_stream->write(data, static_cast<std::streamsize>(size));
+                    return;
+                }
+#endif
+                m_write(m_context, data, size);
+            }
+            void flush()
+            {
+#ifndef BazPO_DISABLE_IOSTREAM
+                if (m_write == nullptr)
+                    m_stream->flush();
+#endif
+                if (m_write == &writeStandardOutput)
+                    std::fflush(stdout);
+            }
+
+            Output& operator<<(const char* text) { write(text, std::strlen(text)); return *this; }
+            Output& operator<<(const std::string& text) { write(text.data(), text.size()); return *this; }
+            Output& operator<<(const StringRef& text) { write(text.c_str(), text.size()); return *this; }
+            // Left aligned text filled with spaces up to the width
+            Output& padded(const StringRef& text, size_t width)
+            {
+                static const char spaces[] = "                                ";
+                *this << text;
+                for (size_t size = text.size(); size < width;)
+                {
+                    size_t count = std::min(width - size, sizeof(spaces) - 1);
+                    write(spaces, count);
+                    size += count;
+                }
+                return *this;
+            }
+
+        private:
+#ifndef BazPO_DISABLE_IOSTREAM
+            std::ostream* m_stream = &std::cout;
+            WriteFunction m_write = nullptr;
+#else
+            WriteFunction m_write = &writeStandardOutput;
+#endif
+            void* m_context = nullptr;
+        };
+
+        // Lines are read from the read function when one is given, otherwise from the input stream
+        class Input
+        {
+        public:
+            static bool readStandardInput(void*, std::string& line)
+            {
+                line.clear();
+                char buffer[256];
+                while (std::fgets(buffer, sizeof(buffer), stdin) != nullptr)
+                {
+                    line.append(buffer);
+                    if (line.back() == '\n')
+                    {
+                        line.pop_back();
+                        return true;
+                    }
+                }
+                return !line.empty();
+            }
+
+            inline void redirect(ReadLineFunction readLine, void* context) { m_readLine = readLine; m_context = context; }
+#ifndef BazPO_DISABLE_IOSTREAM
+            inline void redirect(std::istream* stream) { m_stream = stream; m_readLine = nullptr; }
+#endif
+            bool readLine(std::string& line)
+            {
+#ifndef BazPO_DISABLE_IOSTREAM
+                if (m_readLine == nullptr)
+                    return static_cast<bool>(std::getline(*m_stream, line));
+#endif
+                return m_readLine(m_context, line);
+            }
+
+        private:
+#ifndef BazPO_DISABLE_IOSTREAM
+            std::istream* m_stream = &std::cin;
+            ReadLineFunction m_readLine = nullptr;
+#else
+            ReadLineFunction m_readLine = &readStandardInput;
+#endif
+            void* m_context = nullptr;
+        };
+    }
+
+    // String with static storage duration, options and the Cli refer to it without copying: "--threads"_po
+    class StaticString
+        : public _detail::StringRef
+    {
+    public:
+        constexpr StaticString(const char* text, size_t size) : _detail::StringRef(text, size, true) {}
+    };
+    inline namespace literals
+    {
+        constexpr StaticString operator"" _po(const char* text, size_t size) { return StaticString(text, size); }
+    }
+    enum class OptionType
+    {
+        Value,
+        MultiValue
+    };
+    class ICli
+    {
+    public:
+        ICli() = default;
+        virtual ~ICli() = default;
+        ICli(const ICli&) = delete;
+
+        // Value or Multi Option
+        virtual Option& option(_detail::StringRef option, _detail::StringRef secondOption = "", _detail::StringRef description = "", _detail::StringRef defaultValue = "", OptionType optionType = OptionType::Value, size_t maxValueCount = SIZE_MAX) = 0;
+        // Function Value or Function Multi Option
+        virtual Option& option(_detail::StringRef option, const std::function<void(const Option&)>& onExists, _detail::StringRef secondOption = "", _detail::StringRef description = "", _detail::StringRef defaultValue = "", OptionType optionType = OptionType::Value, size_t maxValueCount = SIZE_MAX) = 0;
+        // Flag Option
+        virtual Option& flag(_detail::StringRef option, _detail::StringRef description = "", _detail::StringRef secondOption = "") = 0;
+        // Function Flag Option
+        virtual Option& flag(_detail::StringRef option, const std::function<void(const Option&)>& onExists, _detail::StringRef description = "", _detail::StringRef secondOption = "") = 0;
+        // Tagless Option
+        virtual Option& tagless(size_t valueCount = 1, _detail::StringRef description = "", _detail::StringRef defaultValue = "") = 0;
+        // Function Tagless Option
+        virtual Option& tagless(const std::function<void(const Option&)>& onExists, size_t valueCount = 1, _detail::StringRef description = "", _detail::StringRef defaultValue = "") = 0;
+        // Any Option Add
+        virtual void option(Option& option) = 0;
+        // Prioritize Option
+        virtual Option& prioritize(_detail::StringRef key) = 0;
+        // Mandatory Option
+        virtual Option& mandatory(_detail::StringRef key) = 0;
+
+    protected:
+        // Program exit
+        virtual void exitWithCode(int code) = 0;
+        virtual void printOptionUsage(const Option& option) = 0;
+        virtual void printOption(const Option& option) = 0;
+        virtual std::string parameterSyntax(const std::string& value, bool mandatory) const = 0;
+        // Value of the option can not be converted, called while parsing and by option functions converting values
+        virtual void conversionError(const Option& option, const char* value) = 0;
+        // Returns a persistent copy of the text, living as long as this
+        virtual _detail::StringRef intern(_detail::StringRef text) = 0;
+
+        int getNextId() { ++m_taglessOptionNextId; return m_taglessOptionNextId; }
+        int getCurrentId() const { return m_taglessOptionNextId; }
+
+    private:
+        int m_taglessOptionNextId = -1;
+
+        friend class Option;
+        friend class MultiConstraint;
+    };
+
+    // Byte size, values are written with SI (kB = 1000) or IEC (KiB = 1024) units: "512MiB", "1.5GB", "4096"
+    struct Bytes
+    {
+        constexpr Bytes() = default;
+        constexpr explicit Bytes(std::uint64_t count) : count(count) {}
+
+        friend constexpr bool operator==(Bytes lhs, Bytes rhs) { return lhs.count == rhs.count; }
+        friend constexpr bool operator!=(Bytes lhs, Bytes rhs) { return lhs.count != rhs.count; }
+        friend constexpr bool operator<(Bytes lhs, Bytes rhs) { return lhs.count < rhs.count; }
+        friend constexpr bool operator<=(Bytes lhs, Bytes rhs) { return lhs.count <= rhs.count; }
+        friend constexpr bool operator>(Bytes lhs, Bytes rhs) { return lhs.count > rhs.count; }
+        friend constexpr bool operator>=(Bytes lhs, Bytes rhs) { return lhs.count >= rhs.count; }
+
+        std::uint64_t count = 0;
+    };
+
+    namespace _detail
+    {
+        enum class OptionParseType
+        {
+            // Single Value
+            Value,
+            // Multiple Values Possible, via single tag "-o val1 val2" 
+            MultiValue,
+            // Tagless
+            Unidentified
+        };
+
+        struct Unit
+        {
+            const char* suffix;
+            std::uint64_t numerator;
+            std::uint64_t denominator;
+        };
+        // Multipliers of numbers, byte sizes add a B: "1.5k", "512Mi", "2GB"
+        inline const Unit* numberUnit(const char* suffix, bool bytes)
+        {
+            static const Unit units[] = {
+                { "", 1, 1 }, { "k", 1000, 1 }, { "K", 1000, 1 }, { "M", 1000000, 1 }, { "G", 1000000000, 1 },
+                { "T", 1000000000000ull, 1 }, { "P", 1000000000000000ull, 1 }, { "E", 1000000000000000000ull, 1 },
+                { "Ki", 1ull << 10, 1 }, { "Mi", 1ull << 20, 1 }, { "Gi", 1ull << 30, 1 }, { "Ti", 1ull << 40, 1 }, { "Pi", 1ull << 50, 1 }, { "Ei", 1ull << 60, 1 } };
+            size_t length = std::strlen(suffix);
+            while (length > 0 && std::isspace(static_cast<unsigned char>(suffix[length - 1])))
+                --length;
+            if (bytes && length > 0 && suffix[length - 1] == 'B')
+                --length;
+            for (const auto& unit : units)
+                if (std::strlen(unit.suffix) == length && std::strncmp(unit.suffix, suffix, length) == 0)
+                    return &unit;
+            return nullptr;
+        }
+        // Durations in seconds, no suffix is a count of the duration itself
+        inline const Unit* durationUnit(const char* suffix)
+        {
+            static const Unit units[] = {
+                { "ns", 1, 1000000000 }, { "us", 1, 1000000 }, { "\xC2\xB5s", 1, 1000000 }, { "ms", 1, 1000 },
+                { "s", 1, 1 }, { "min", 60, 1 }, { "h", 3600, 1 }, { "d", 86400, 1 } };
+            size_t length = std::strlen(suffix);
+            while (length > 0 && std::isspace(static_cast<unsigned char>(suffix[length - 1])))
+                --length;
+            for (const auto& unit : units)
+                if (std::strlen(unit.suffix) == length && std::strncmp(unit.suffix, suffix, length) == 0)
+                    return &unit;
+            return nullptr;
+        }
+
+        inline std::uint64_t greatestCommonDivisor(std::uint64_t a, std::uint64_t b)
+        {
+            while (b != 0)
+            {
+                auto remainder = a % b;
+                a = b;
+                b = remainder;
+            }
+            return a;
+        }
+        inline bool multiply(std::uint64_t a, std::uint64_t b, std::uint64_t& result)
+        {
+            if (a != 0 && b > UINT64_MAX / a)
+                return false;
+            result = a * b;
+            return true;
+        }
+        inline unsigned digitValue(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return static_cast<unsigned>(c - '0');
+            if (c >= 'a' && c <= 'z')
+                return static_cast<unsigned>(c - 'a' + 10);
+            if (c >= 'A' && c <= 'Z')
+                return static_cast<unsigned>(c - 'A' + 10);
+            return UINT32_MAX;
+        }
+
+        // Number as written: sign, 0x/0o/0b prefix, digits separated by ' or _, decimal fraction and the unit following it.
+        // Numbers with a prefix have no fraction or unit since units could be read as digits.
+        struct WrittenNumber
+        {
+            bool negative = false;
+            std::uint64_t digits = 0;
+            // Ten to the power of the fraction digit count
+            std::uint64_t scale = 1;
+            const char* unit = "";
+        };
+        inline bool readNumber(const char* text, WrittenNumber& number)
+        {
+            while (std::isspace(static_cast<unsigned char>(*text)))
+                ++text;
+            if (*text == '+' || *text == '-')
+                number.negative = *text++ == '-';
+            unsigned base = 10;
+            if (text[0] == '0' && text[1] != '\0' && std::strchr("xXoObB", text[1]) != nullptr)
+            {
+                unsigned prefixBase = text[1] == 'x' || text[1] == 'X' ? 16 : text[1] == 'o' || text[1] == 'O' ? 8 : 2;
+                // "0B" is zero bytes
+                if (digitValue(text[2]) < prefixBase)
+                {
+                    base = prefixBase;
+                    text += 2;
+                }
+            }
+            bool digitRead = false;
+            bool fraction = false;
+            for (;; ++text)
+            {
+                unsigned digit = digitValue(*text);
+                if (digit < base)
+                {
+                    if (!multiply(number.digits, base, number.digits) || number.digits > UINT64_MAX - digit || (fraction && !multiply(number.scale, 10, number.scale)))
+                        return false;
+                    number.digits += digit;
+                    digitRead = true;
+                }
+                else if ((*text == '\'' || *text == '_') && digitRead && digitValue(text[1]) < base)
+                    continue;
+                else if (*text == '.' && base == 10 && digitRead && !fraction && digitValue(text[1]) < base)
+                    fraction = true;
+                else
+                    break;
+            }
+            while (std::isspace(static_cast<unsigned char>(*text)))
+                ++text;
+            number.unit = text;
+            return digitRead && (base == 10 || *text == '\0');
+        }
+        // Written number multiplied by numerator / denominator, fails when it overflows or is not a whole number
+        inline bool scaleNumber(const WrittenNumber& number, std::uint64_t numerator, std::uint64_t denominator, std::uint64_t& result)
+        {
+            std::uint64_t divisor = 0;
+            if (!multiply(number.scale, denominator, divisor))
+                return false;
+            auto common = greatestCommonDivisor(numerator, divisor);
+            numerator /= common;
+            divisor /= common;
+            auto digits = number.digits;
+            common = greatestCommonDivisor(digits, divisor);
+            digits /= common;
+            divisor /= common;
+            return divisor == 1 && multiply(digits, numerator, result);
+        }
+        template <typename T>
+        typename std::enable_if<std::is_unsigned<T>::value, bool>::type toInteger(bool negative, std::uint64_t magnitude, T& value)
+        {
+            if (magnitude > static_cast<std::uint64_t>(std::numeric_limits<T>::max()) || (negative && magnitude != 0))
+                return false;
+            value = static_cast<T>(magnitude);
+            return true;
+        }
+        template <typename T>
+        typename std::enable_if<std::is_signed<T>::value, bool>::type toInteger(bool negative, std::uint64_t magnitude, T& value)
+        {
+            if (magnitude > static_cast<std::uint64_t>(std::numeric_limits<T>::max()) + (negative ? 1 : 0))
+                return false;
+            value = negative ? static_cast<T>(-static_cast<std::int64_t>(magnitude - 1) - 1) : static_cast<T>(magnitude);
+            return true;
+        }
+        // Floating point number followed by a unit, reads exponents and hexadecimal fractions as well
+        inline bool readFloatingPoint(const char* text, long double& value, const char*& unit)
+        {
+            char* end = nullptr;
+            errno = 0;
+            value = std::strtold(text, &end);
+            if (end == text || errno == ERANGE)
+                return false;
+            for (unit = end; std::isspace(static_cast<unsigned char>(*unit));)
+                ++unit;
+            return true;
+        }
+
+        // Integers: "0xff00", "1'000'000", "1.5k", "64Ki"
+        template <typename T>
+        typename std::enable_if<std::is_integral<T>::value && (sizeof(T) > 1), bool>::type convertNumber(const char* text, T& value)
+        {
+            WrittenNumber number;
+            std::uint64_t magnitude = 0;
+            if (!readNumber(text, number))
+                return false;
+            auto unit = numberUnit(number.unit, false);
+            return unit != nullptr && scaleNumber(number, unit->numerator, unit->denominator, magnitude) && toInteger(number.negative, magnitude, value);
+        }
+        // Characters are read as the first non whitespace character
+        template <typename T>
+        typename std::enable_if<std::is_integral<T>::value && sizeof(T) == 1, bool>::type convertNumber(const char* text, T& value)
+        {
+            while (std::isspace(static_cast<unsigned char>(*text)))
+                ++text;
+            value = static_cast<T>(*text);
+            return *text != '\0';
+        }
+        // Floating point numbers: "0.25", "1e-3", "1.5k"
+        template <typename T>
+        typename std::enable_if<std::is_floating_point<T>::value, bool>::type convertNumber(const char* text, T& value)
+        {
+            long double v = 0;
+            const char* suffix = nullptr;
+            if (!readFloatingPoint(text, v, suffix))
+                return false;
+            auto unit = numberUnit(suffix, false);
+            if (unit == nullptr)
+                return false;
+            v = v * unit->numerator / unit->denominator;
+            if (v < -std::numeric_limits<T>::max() || v > std::numeric_limits<T>::max())
+                return false;
+            value = static_cast<T>(v);
+            return true;
+        }
+
+        template <typename T>
+        typename std::enable_if<std::is_arithmetic<T>::value, bool>::type convertValue(const char* text, T& value) { return convertNumber(text, value); }
+        // Byte sizes: "512MiB", "1.5GB", "0x1000"
+        inline bool convertValue(const char* text, Bytes& value)
+        {
+            WrittenNumber number;
+            if (!readNumber(text, number) || number.negative)
+                return false;
+            auto unit = numberUnit(number.unit, true);
+            return unit != nullptr && scaleNumber(number, unit->numerator, unit->denominator, value.count);
+        }
+        // Durations: "250ms", "1.5s", "2h", a number without unit is a count of the duration
+        template <typename Rep, typename Period>
+        typename std::enable_if<std::is_integral<Rep>::value, bool>::type convertValue(const char* text, std::chrono::duration<Rep, Period>& value)
+        {
+            WrittenNumber number;
+            if (!readNumber(text, number))
+                return false;
+            auto unit = durationUnit(number.unit);
+            if (unit == nullptr && *number.unit != '\0')
+                return false;
+            // Count of the duration is the number multiplied by unit / period
+            std::uint64_t numerator = unit != nullptr ? unit->numerator : Period::num;
+            std::uint64_t denominator = unit != nullptr ? unit->denominator : Period::den;
+            auto common = greatestCommonDivisor(numerator, static_cast<std::uint64_t>(Period::num));
+            std::uint64_t periodNumerator = static_cast<std::uint64_t>(Period::num) / common;
+            numerator /= common;
+            common = greatestCommonDivisor(denominator, static_cast<std::uint64_t>(Period::den));
+            std::uint64_t periodDenominator = static_cast<std::uint64_t>(Period::den) / common;
+            denominator /= common;
+            std::uint64_t magnitude = 0;
+            Rep count{};
+            if (!multiply(numerator, periodDenominator, numerator) || !multiply(denominator, periodNumerator, denominator) ||
+                !scaleNumber(number, numerator, denominator, magnitude) || !toInteger(number.negative, magnitude, count))
+                return false;
+            value = std::chrono::duration<Rep, Period>(count);
+            return true;
+        }
+        template <typename Rep, typename Period>
+        typename std::enable_if<std::is_floating_point<Rep>::value, bool>::type convertValue(const char* text, std::chrono::duration<Rep, Period>& value)
+        {
+            long double v = 0;
+            const char* suffix = nullptr;
+            if (!readFloatingPoint(text, v, suffix))
+                return false;
+            auto unit = durationUnit(suffix);
+            if (unit == nullptr && *suffix != '\0')
+                return false;
+            if (unit != nullptr)
+                v = v * unit->numerator * Period::den / (static_cast<long double>(unit->denominator) * Period::num);
+            if (v < -std::numeric_limits<Rep>::max() || v > std::numeric_limits<Rep>::max())
+                return false;
+            value = std::chrono::duration<Rep, Period>(static_cast<Rep>(v));
+            return true;
+        }
+#ifndef BazPO_DISABLE_IOSTREAM
+        // Other types are read from a stream
+        template <typename T>
+        typename std::enable_if<!std::is_arithmetic<T>::value, bool>::type convertValue(const char* text, T& value)
+        {
+            std::stringstream ss;
+            ss << text;
+            ss >> value;
+            return !ss.fail();
+        }
+#else
+        template <typename T>
+        typename std::enable_if<!std::is_arithmetic<T>::value, bool>::type convertValue(const char* /*text*/, T& /*value*/)
+        {
+            static_assert(sizeof(T) == 0, "Only numbers, Bytes and durations are converted when BazPO_DISABLE_IOSTREAM is defined");
+            return false;
+        }
+#endif
+        template <typename T>
+        std::pair<T, bool> valueAs(const std::string& value)
+        {
+            T v{};
+            bool converted = convertValue(value.c_str(), v);
+            return { v, !converted };
+        }
+
+        // Limits of constraints are written like the values
+        template <typename T>
+        typename std::enable_if<std::is_arithmetic<T>::value, std::string>::type toString(T value) { return std::to_string(value); }
+        inline std::string toString(Bytes value)
+        {
+            static const char* const units[] = { "B", "KiB", "MiB", "GiB", "TiB", "PiB", "EiB" };
+            size_t unit = 0;
+            auto count = value.count;
+            while (count != 0 && count % 1024 == 0 && unit + 1 < sizeof(units) / sizeof(units[0]))
+            {
+                count /= 1024;
+                ++unit;
+            }
+            return std::to_string(count).append(units[unit]);
+        }
+        template <typename Rep, typename Period>
+        std::string toString(std::chrono::duration<Rep, Period> value)
+        {
+            for (const char* suffix : { "ns", "us", "ms", "s", "min", "h", "d" })
+            {
+                auto unit = durationUnit(suffix);
+                if (unit->numerator == static_cast<std::uint64_t>(Period::num) && unit->denominator == static_cast<std::uint64_t>(Period::den))
+                    return toString(value.count()).append(suffix);
+            }
+            return toString(std::chrono::duration<double>(value).count()).append("s");
+        }
+        template <>
+        inline std::pair<bool, bool> valueAs(const std::string& value) { return { (value == "1" || value == "True" || value == "true" || value == "t" || value == "y"), false }; }
+        template <>
+        inline std::pair<std::string, bool> valueAs(const std::string& value) { return { value, false }; }
+        template <typename T>
+        std::pair<std::deque<T>, bool> valuesAs(const std::deque<const char*>& values)
+        {
+            std::deque<T> ret;
+            for (auto it : values)
+            {
+                auto val = valueAs<T>(it);
+                ret.emplace_back(val.first);
+                if (val.second)
+                    return { ret, true };
+            }
+            return { ret, false };
+        }
+
+        class PrioritizationOptionMismatch
+            : public std::exception
+        {
+            const char* err = "Tagless options cannot be prioritized!";
+            const char* what() const noexcept override { return err; };
+        };
+        class CallbackDependencyCycle
+            : public std::exception
+        {
+            const char* err = "Option functions depend on each other!";
+            const char* what() const noexcept override { return err; };
+        };
+        class UnknownDependency
+            : public std::exception
+        {
+        public:
+            explicit UnknownDependency(const std::string& key) : err("Option function depends on an unknown option: " + key) {}
+        private:
+            std::string err;
+            const char* what() const noexcept override { return err.c_str(); };
+        };
+        class InvalidDefaultValue
+            : public std::exception
+        {
+            const char* err = "Default value can not be converted!";
+            const char* what() const noexcept override { return err; };
+        };
+        class InvalidConstraintLimit
+            : public std::exception
+        {
+            const char* err = "Constraint limit can not be converted!";
+            const char* what() const noexcept override { return err; };
+        };
+    }
+
+    // Dense index of an option in the order of registration, valid for the Cli registering the option and for its serialized views
+    struct OptionHandle
+    {
+        std::uint32_t index = UINT32_MAX;
+
+        inline bool valid() const { return index != UINT32_MAX; }
+        friend bool operator==(OptionHandle lhs, OptionHandle rhs) { return lhs.index == rhs.index; }
+        friend bool operator!=(OptionHandle lhs, OptionHandle rhs) { return lhs.index != rhs.index; }
+    };
+
+    // Descriptions in one read-only block separated by '\0', options refer to them by index instead of keeping a copy.
+    // A compressed block is decompressed by the given function when a description is needed for the first time,
+    // which is when help or an error is printed. The table has to outlive the options referring to it.
+    class DescriptionTable
+    {
+    public:
+        // Returns the descriptions separated by '\0'
+        using Decompress = std::string (*)(const char* data, size_t size);
+
+        // Size of the block includes the separators, sizeof(literal) - 1 of a string literal
+        DescriptionTable(const char* data, size_t size, Decompress decompress = nullptr)
+            : m_data(data)
+            , m_size(size)
+            , m_decompress(decompress)
+        {}
+        DescriptionTable(const DescriptionTable&) = delete;
+
+        // Empty when there is no description at the index
+        _detail::StringRef operator[](size_t index) const
+        {
+            load();
+            return index < m_descriptions.size() ? m_descriptions[index] : _detail::StringRef();
+        }
+        inline size_t size() const { load(); return m_descriptions.size(); }
+        inline bool loaded() const { return m_loaded; }
+
+    private:
+        void load() const
+        {
+            if (m_loaded)
+                return;
+            m_loaded = true;
+            const char* text = m_data;
+            size_t size = m_size;
+            if (m_decompress != nullptr)
+            {
+                m_text = m_decompress(m_data, m_size);
+                text = m_text.c_str();
+                size = m_text.size();
+            }
+            // Every description ends with a separator, the last one may end with the block
+            for (size_t begin = 0; begin < size;)
+            {
+                const char* end = static_cast<const char*>(std::memchr(text + begin, '\0', size - begin));
+                const size_t length = end != nullptr ? static_cast<size_t>(end - text) - begin : size - begin;
+                m_descriptions.emplace_back(text + begin, length, end != nullptr);
+                begin += length + 1;
+            }
+        }
+
+        const char* m_data;
+        size_t m_size;
+        Decompress m_decompress;
+        mutable std::string m_text;
+        mutable std::vector<_detail::StringRef> m_descriptions;
+        mutable bool m_loaded = false;
+    };
+
+    class Option
+    {
+    protected:
+        Option(_detail::StringRef parameter, _detail::StringRef secondParameter, _detail::StringRef description, _detail::StringRef defaultValue, bool mandatory, _detail::OptionParseType parser, ICli* po = nullptr)
+            : ParseType(parser)
+            , Mandatory(mandatory)
+            , po(po)
+        {
+            Parameter = keep(parameter);
+            SecondParameter = keep(secondParameter);
+            Description = keep(description);
+            DefaultValue = keep(defaultValue);
+            if (!DefaultValue.empty())
+                Value = DefaultValue.c_str();
+            if (po != nullptr)
+            {
+                if (Parameter.empty())
+                    Parameter = po->intern(std::to_string(po->getNextId()));
+
+                po->option(*this);
+            }
+        }
+    public:
+        Option() = delete;
+        Option(const Option&) = delete;
+        virtual ~Option() = default;
+
+        inline bool exists() const { return Exists; }
+        inline int existsCount() const { return ExistsCount; }
+        inline const char* value() const { return Value; }
+        inline const std::deque<const char*>& values() const { return Values; }
+        // Handle given when the option is registered, reads through the handle do not look the option up
+        inline OptionHandle handle() const { return Handle; }
+        Option& prioritize()
+        {
+            if (ParseType == _detail::OptionParseType::Unidentified)
+                BazPO_THROW(_detail::PrioritizationOptionMismatch());
+            Prioritized = true;
+            po->prioritize(Parameter);
+            return *this;
+        }
+        Option& withMaxValueCount(size_t count) { MaxValueCount = count; return *this; }
+        // Function of this option is executed after the function of the given option
+        Option& dependsOn(const std::string& key) { Dependencies.emplace_back(key); return *this; }
+        // Description is read from the table when it is printed, replaces the given description
+        Option& describedBy(const DescriptionTable& table, size_t index) { Descriptions = &table; DescriptionIndex = index; return *this; }
+        Option& mandatory() { Mandatory = true; return *this; }
+        Option& constrain(std::deque<std::string> stringConstraints);
+        template<typename T>
+        Option& constrain(std::pair<T, T> minMaxConstraints);
+        // Limits are written like the values: constrain<Bytes>("1MiB", "1GiB")
+        template<typename T>
+        Option& constrain(const char* min, const char* max);
+        Option& constrain(const std::function<bool(const Option&)>& isSatisfied, const std::string& errorMessage);
+        Option& constrain(Constraint& contraint) { Constrained.emplace_back(&contraint); return *this; };
+
+        template <typename T>
+        inline T valueAs() const
+        {
+            auto valPair = _detail::valueAs<T>(Value);
+            if (valPair.second)
+                po->conversionError(*this, Value);
+            return valPair.first;
+        }
+        template <typename T>
+        inline std::deque<T> valuesAs() const
+        {
+            auto valPair = _detail::valuesAs<T>(Values);
+            if (valPair.second)
+                po->conversionError(*this, Values[valPair.first.size() - 1]);
+            return valPair.first;
+        }
+
+    protected:
+        void setValue(const char* value) { Value = value; Values.emplace_back(value); };
+        // Called for every value set while parsing, options storing converted values convert here
+        virtual bool convert(const char* /*value*/) { return true; };
+        virtual void execute(const Option&) const { /* there is nothing to execute by default */ };
+        // Appends the values starting with prefix that are accepted by this option, each ending with a new line
+        virtual void complete(const char* prefix, std::string& candidates) const;
+        size_t maxValueCount() const { return MaxValueCount; }
+        void notMandatory() { Mandatory = false; }
+
+    private:
+        void setCli(ICli& cli) { po = &cli; }
+        inline _detail::StringRef description() const { return Descriptions != nullptr ? (*Descriptions)[DescriptionIndex] : Description; }
+        // Literals and strings interned by the Cli are referred to, anything else is copied
+        _detail::StringRef keep(_detail::StringRef text)
+        {
+            if (text.persistent() || text.empty())
+                return text.empty() ? _detail::StringRef() : text;
+            if (po != nullptr)
+                return po->intern(text);
+            if (!OwnedStrings)
+                OwnedStrings.reset(new _detail::StringPool());
+            return OwnedStrings->intern(text);
+        }
+
+        _detail::StringRef Parameter;
+        _detail::StringRef SecondParameter;
+        _detail::StringRef Description;
+        const DescriptionTable* Descriptions = nullptr;
+        size_t DescriptionIndex = 0;
+        _detail::StringRef DefaultValue;
+        std::unique_ptr<_detail::StringPool> OwnedStrings;
+        _detail::OptionParseType ParseType;
+        bool Exists = false;
+        int ExistsCount = 0;
+        bool Mandatory = false;
+        bool Prioritized = false;
+        std::deque<Constraint*> Constrained;
+        std::deque<MultiConstraint*> MultiConstrained;
+        std::deque<std::shared_ptr<Constraint>> ConstraintStorage;
+        std::deque<std::string> Dependencies;
+
+        ICli* po;
+        OptionHandle Handle;
+        size_t SourceRank = 0;
+        friend class Cli;
+        friend class Constraint;
+        friend class MultiConstraint;
+        friend class _detail::Serializer;
+        friend class _detail::RegistrationTimer;
+        friend class CallbackExecutor;
+        friend struct Diagnostic;
+
+        const char* Value = "";
+        std::deque<const char*> Values;
+        size_t MaxValueCount = 1;
+    };
+
+    class Constraint
+    {
+    protected:
+        explicit Constraint(Option& option)
+            : option(option)
+        {
+            option.constrain(*this);
+        }
+    public:
+        Constraint() = delete;
+        Constraint(const Constraint&) = delete;
+        virtual ~Constraint() = default;
+
+        virtual bool satisfied() const = 0;
+        virtual std::string what() const = 0;
+        // Appends the accepted values starting with prefix, each ending with a new line
+        virtual void complete(const char* /*prefix*/, std::string& /*candidates*/) const { /* values can not be listed by default */ };
+        // Constraints checking each value accept or reject every value of the option after parsing, possibly from several threads.
+        // Other constraints are checked with satisfied() after parsing while each value is the value of the option.
+        virtual bool checksEachValue() const { return false; }
+        virtual bool accepts(const char* /*value*/) const { return satisfied(); }
+        // Rejected values the constraint can not convert are reported as invalid values instead of violations
+        virtual bool converts(const char* /*value*/) const { return true; }
+    protected:
+        Option& option;
+    };
+
+    class StringConstraint
+        : public Constraint
+    {
+    public:
+        StringConstraint(Option& option, const std::deque<std::string>& stringConstraints)
+            : Constraint(option)
+            , constraints(stringConstraints)
+        {}
+
+        virtual bool satisfied() const override { return accepts(option.value()); };
+        virtual bool checksEachValue() const override { return true; }
+        virtual bool accepts(const char* value) const override { return std::any_of(constraints.begin(), constraints.end(), [value](const std::string& constraint) { return constraint == value; }); }
+        virtual std::string what() const override
+        {
+            std::string str;
+            str.append("value either to be ");
+            for (auto& constraint : constraints)
+                str.append(constraint).append(", ");
+            return str;
+        };
+        virtual void complete(const char* prefix, std::string& candidates) const override
+        {
+            const size_t prefixSize = std::strlen(prefix);
+            for (const auto& constraint : constraints)
+                if (constraint.compare(0, prefixSize, prefix) == 0)
+                    candidates.append(constraint).append("\n");
+        }
+    private:
+        std::deque<std::string> constraints;
+    };
+    class FunctionConstraint
+        : public Constraint
+    {
+    public:
+        FunctionConstraint(Option& option, const std::function<bool(const Option&)>& isSatisfied, const std::string& errorMessage)
+            : Constraint(option)
+            , isSatisfied(isSatisfied)
+            , errorMessage(errorMessage)
+        {}
+
+        virtual bool satisfied() const override { return isSatisfied(option); };
+        virtual std::string what() const override { return errorMessage; };
+    private:
+        std::function<bool(const Option&)> isSatisfied;
+        std::string errorMessage;
+    };
+    template <typename T>
+    class MinMaxConstraint
+        : public Constraint
+    {
+    public:
+        MinMaxConstraint(Option& option, const std::pair<T, T>& minMaxConstraint)
+            : Constraint(option)
+            , constraint(minMaxConstraint)
+        {}
+
+        virtual bool satisfied() const override
+        {
+            T val = option.valueAs<T>();
+            return val >= constraint.first && val <= constraint.second;
+        };
+        virtual bool checksEachValue() const override { return true; }
+        // Values that can not be converted are not accepted
+        virtual bool accepts(const char* value) const override
+        {
+            auto val = _detail::valueAs<T>(value);
+            return !val.second && val.first >= constraint.first && val.first <= constraint.second;
+        }
+        virtual bool converts(const char* value) const override { return !_detail::valueAs<T>(value).second; }
+        virtual std::string what() const override { return std::string("values to be between ").append(_detail::toString(constraint.first)).append(", ").append(_detail::toString(constraint.second)); };
+
+    private:
+        std::pair<T, T> constraint;
+    };
+
+    class MultiConstraint
+    {
+    public:
+        MultiConstraint() = delete;
+        MultiConstraint(const MultiConstraint&) = delete;
+        virtual ~MultiConstraint() = default;
+
+    protected:
+        template <typename... Options>
+        explicit MultiConstraint(ICli* po, Option& option1, Option& option2, Options&... rest)
+            : cli(po)
+        {
+            addOptions(option1, option2, rest...);
+        }
+
+        virtual bool satisfied(Option& foundOption) = 0;
+        virtual std::string what() = 0;
+
+        bool isMandatory(const Option& option) const { return option.Mandatory; }
+        std::string parameterSyntax(const Option& option) const { return cli->parameterSyntax(option.Parameter, option.Mandatory); }
+
+        std::deque<std::pair<Option*, bool>> relativeOptions;
+        ICli* cli = nullptr;
+    private:
+        void addOptions(Option& option1) { option1.MultiConstrained.emplace_back(this); relativeOptions.emplace_back(&option1, false); }
+        template <typename... Options>
+        void addOptions(Option& option1, Options&... rest) { addOptions(option1); addOptions(rest...); }
+
+        friend class Cli;
+        friend struct Diagnostic;
+    };
+
+    template<typename T>
+    Option& Option::constrain(std::pair<T, T> minMaxConstraints) { ConstraintStorage.emplace_back(std::make_shared<MinMaxConstraint<T>>(*this, minMaxConstraints)); return *this; };
+    template <typename T>
+    Option& Option::constrain(const char* min, const char* max)
+    {
+        auto minimum = _detail::valueAs<T>(min);
+        auto maximum = _detail::valueAs<T>(max);
+        if (minimum.second || maximum.second)
+            BazPO_THROW(_detail::InvalidConstraintLimit());
+        return constrain(std::make_pair(minimum.first, maximum.first));
+    }
+
+    class MutuallyExclusive
+        : public MultiConstraint
+    {
+    public:
+        template <typename... Options>
+        explicit MutuallyExclusive(ICli* po, Option& option1, Option& option2, Options&... rest)
+            : MultiConstraint(po, option1, option2, rest...)
+        {}
+
+        Option* satisfiedOption() const { return chosenOption; }
+    protected:
+        virtual bool satisfied(Option& foundOption) override
+        {
+            auto totalExist = 0;
+            for (auto& option : relativeOptions)
+            {
+                totalExist += option.first->exists();
+                if (totalExist > 1)
+                    return false;
+                else if (option.first == &foundOption && chosenOption == nullptr && foundOption.exists())
+                {
+                    option.second = true;
+                    chosenOption = option.first;
+                }
+            }
+            return chosenOption != nullptr || !isAnyMandatory();
+        }
+
+        virtual std::string what() override
+        {
+            std::string msg;
+            msg.append("Only one of the ");
+            for (const auto& option : relativeOptions)
+            {
+                msg.append(parameterSyntax(*option.first));
+                if(option.first != relativeOptions.back().first)
+                    msg.append(", ");
+            }
+            msg.append(" parameters must be provided");
+            return msg;
+        }
+
+    private:
+        bool isAnyMandatory(){ return std::any_of(relativeOptions.begin(), relativeOptions.end(), [this](const auto& optionPair) { return isMandatory(*optionPair.first); });}
+
+        Option* chosenOption = nullptr;
+    };
+
+    class ValueOption
+        : public Option
+    {
+    public:
+        ValueOption(ICli* po, _detail::StringRef parameter, _detail::StringRef secondParameter = "", _detail::StringRef description = "", _detail::StringRef defaultValue = "", bool mandatory = false, size_t maxValueCount = SIZE_MAX)
+            : Option(parameter, secondParameter, description, defaultValue, mandatory, _detail::OptionParseType::Value, po)
+        {
+            withMaxValueCount(maxValueCount);
+        };
+    };
+
+    class FlagOption
+        : public Option
+    {
+    public:
+        FlagOption(ICli* po, _detail::StringRef parameter, _detail::StringRef description = "", _detail::StringRef secondParameter = "", bool mandatory = false)
+            : Option(parameter, secondParameter, description, "", mandatory, _detail::OptionParseType::Value, po)
+        {
+            withMaxValueCount(0);
+        };
+    };
+
+    class MultiOption
+        : public Option
+    {
+    public:
+        MultiOption(ICli* po, _detail::StringRef parameter, _detail::StringRef secondParameter = "", _detail::StringRef description = "", _detail::StringRef defaultValue = "", bool mandatory = false, size_t maxValueCount = SIZE_MAX)
+            : Option(parameter, secondParameter, description, defaultValue, mandatory, _detail::OptionParseType::MultiValue, po)
+        {
+            withMaxValueCount(maxValueCount);
+        };
+    };
+
+    class TaglessOption
+        : public Option
+    {
+    public:
+        TaglessOption(ICli* po, size_t valueCount = 1, _detail::StringRef description = "", _detail::StringRef defaultValue = "", bool mandatory = false)
+            : Option("", "", description, defaultValue, mandatory, _detail::OptionParseType::Unidentified, po)
+        {
+            withMaxValueCount(valueCount);
+        };
+    };
+    // Converts each value once while parsing and stores the converted values
+    template <typename T>
+    class TypedOption
+        : public ValueOption
+    {
+    public:
+        TypedOption(ICli* po, _detail::StringRef parameter, _detail::StringRef secondParameter = "", _detail::StringRef description = "", const T& defaultValue = T(), bool mandatory = false)
+            : ValueOption(po, parameter, secondParameter, description, "", mandatory)
+            , typedValue(defaultValue)
+        {}
+
+        inline const T& get() const { return typedValue; }
+    protected:
+        virtual bool convert(const char* value) override
+        {
+            auto valPair = _detail::valueAs<T>(value);
+            if (valPair.second)
+                return false;
+            typedValue = std::move(valPair.first);
+            return true;
+        }
+    private:
+        T typedValue;
+    };
+
+    template <typename T>
+    class TypedMultiOption
+        : public MultiOption
+    {
+    public:
+        TypedMultiOption(ICli* po, _detail::StringRef parameter, _detail::StringRef secondParameter = "", _detail::StringRef description = "", std::vector<T> defaultValues = {}, bool mandatory = false, size_t maxValueCount = SIZE_MAX)
+            : MultiOption(po, parameter, secondParameter, description, "", mandatory, maxValueCount)
+            , typedValues(std::move(defaultValues))
+        {}
+
+        inline const std::vector<T>& get() const { return typedValues; }
+    protected:
+        virtual bool convert(const char* value) override
+        {
+            auto valPair = _detail::valueAs<T>(value);
+            if (valPair.second)
+                return false;
+            // Provided values replace the default values
+            if (values().size() == 1)
+                typedValues.clear();
+            typedValues.emplace_back(std::move(valPair.first));
+            return true;
+        }
+    private:
+        std::vector<T> typedValues;
+    };
+
+    // Sets of integers such as "0-4095,8192-12287:4,20000", stored as sorted intervals with disjoint bounds.
+    // Values of every occurrence are merged into the same set, overlapping intervals are split where they overlap.
+    class RangeOption
+        : public ValueOption
+    {
+    public:
+        struct Interval
+        {
+            std::uint64_t first;
+            std::uint64_t last;
+            std::uint64_t step;
+
+            std::uint64_t count() const { return (last - first) / step + 1; }
+        };
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::uint64_t;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::uint64_t*;
+            using reference = std::uint64_t;
+
+            iterator(const std::vector<Interval>& intervals, size_t index) : intervals(&intervals), index(index), current(index < intervals.size() ? intervals[index].first : 0) {}
+            std::uint64_t operator*() const { return current; }
+            iterator& operator++()
+            {
+                const auto& interval = (*intervals)[index];
+                if (interval.last - current >= interval.step)
+                    current += interval.step;
+                else if (++index < intervals->size())
+                    current = (*intervals)[index].first;
+                else
+                    current = 0;
+                return *this;
+            }
+            iterator operator++(int) { iterator it = *this; ++*this; return it; }
+            bool operator==(const iterator& other) const { return index == other.index && current == other.current; }
+            bool operator!=(const iterator& other) const { return !(*this == other); }
+        private:
+            const std::vector<Interval>* intervals;
+            size_t index;
+            std::uint64_t current;
+        };
+
+        RangeOption(ICli* po, _detail::StringRef parameter, _detail::StringRef secondParameter = "", _detail::StringRef description = "", _detail::StringRef defaultValue = "", bool mandatory = false)
+            : ValueOption(po, parameter, secondParameter, description, "", mandatory)
+        {
+            if (!defaultValue.empty() && !parse(defaultValue.c_str()))
+                BazPO_THROW(_detail::InvalidDefaultValue());
+        }
+
+        inline bool contains(std::uint64_t value) const
+        {
+            auto interval = std::upper_bound(ranges.begin(), ranges.end(), value, [](std::uint64_t v, const Interval& i) { return v < i.first; });
+            if (interval == ranges.begin())
+                return false;
+            --interval;
+            return value <= interval->last && (value - interval->first) % interval->step == 0;
+        }
+        inline std::uint64_t count() const
+        {
+            std::uint64_t total = 0;
+            for (const auto& interval : ranges)
+                total += interval.count();
+            return total;
+        }
+        inline bool empty() const { return ranges.empty(); }
+        inline const std::vector<Interval>& intervals() const { return ranges; }
+        inline iterator begin() const { return { ranges, 0 }; }
+        inline iterator end() const { return { ranges, ranges.size() }; }
+
+    protected:
+        virtual bool convert(const char* value) override
+        {
+            // Provided values replace the default range
+            if (values().size() == 1)
+                ranges.clear();
+            return parse(value);
+        }
+
+    private:
+        static bool parseNumber(const char*& it, std::uint64_t& number)
+        {
+            if (!std::isdigit(static_cast<unsigned char>(*it)))
+                return false;
+            number = 0;
+            for (; std::isdigit(static_cast<unsigned char>(*it)); ++it)
+            {
+                std::uint64_t digit = static_cast<std::uint64_t>(*it - '0');
+                if (number > (UINT64_MAX - digit) / 10)
+                    return false;
+                number = number * 10 + digit;
+            }
+            return true;
+        }
+
+        // Adds the intervals only when the whole value is valid
+        bool parse(const char* value)
+        {
+            std::vector<Interval> parsed;
+            for (const char* it = value;; ++it)
+            {
+                Interval interval{ 0, 0, 1 };
+                if (!parseNumber(it, interval.first))
+                    return false;
+                interval.last = interval.first;
+                if (*it == '-' && !parseNumber(++it, interval.last))
+                    return false;
+                if (*it == ':' && (!parseNumber(++it, interval.step) || interval.step == 0))
+                    return false;
+                if (interval.last < interval.first)
+                    return false;
+                // Last value is always a member of the interval
+                interval.last -= (interval.last - interval.first) % interval.step;
+                if (interval.first == interval.last)
+                    interval.step = 1;
+                parsed.push_back(interval);
+                if (*it == '\0')
+                    break;
+                if (*it != ',')
+                    return false;
+            }
+            for (const auto& interval : parsed)
+                add(interval);
+            normalize();
+            return true;
+        }
+
+        // Members of the interval between from and to, false when there are none
+        static bool restrict(const Interval& interval, std::uint64_t from, std::uint64_t to, Interval& part)
+        {
+            if (to < interval.first || from > interval.last)
+                return false;
+            const std::uint64_t skipped = from > interval.first ? from - interval.first : 0;
+            const std::uint64_t firstIndex = skipped / interval.step + (skipped % interval.step != 0 ? 1 : 0);
+            const std::uint64_t lastIndex = (std::min(to, interval.last) - interval.first) / interval.step;
+            if (firstIndex > lastIndex)
+                return false;
+            part = { interval.first + firstIndex * interval.step, interval.first + lastIndex * interval.step, interval.step };
+            if (part.first == part.last)
+                part.step = 1;
+            return true;
+        }
+
+        // Appends an interval starting after the last one, extends the last one when the values continue its steps.
+        // A single value only takes the step of the next value when adoptStep is set.
+        static void append(std::vector<Interval>& intervals, const Interval& interval, bool adoptStep = false)
+        {
+            if (!intervals.empty())
+            {
+                auto& previous = intervals.back();
+                const std::uint64_t gap = interval.first - previous.last;
+                const bool singlePrevious = previous.first == previous.last;
+                const bool singleCurrent = interval.first == interval.last;
+                if (singlePrevious && adoptStep && (singleCurrent || gap == interval.step))
+                {
+                    previous = { previous.first, interval.last, gap };
+                    return;
+                }
+                if ((previous.step == 1 && interval.step == 1 && gap == 1) || (!singlePrevious && (previous.step == interval.step || singleCurrent) && gap == previous.step))
+                {
+                    previous.last = interval.last;
+                    return;
+                }
+            }
+            intervals.push_back(interval);
+        }
+
+        // Keeps the intervals sorted with disjoint bounds. Where the interval overlaps an existing one the common part is
+        // replaced by the union of their values: one of them when it already holds every value, otherwise the values in order.
+        void add(Interval interval)
+        {
+            for (;;)
+            {
+                auto it = std::lower_bound(ranges.begin(), ranges.end(), interval.first, [](const Interval& i, std::uint64_t v) { return i.last < v; });
+                if (it == ranges.end() || it->first > interval.last)
+                {
+                    ranges.insert(it, interval);
+                    return;
+                }
+                const Interval existing = *it;
+                const size_t position = static_cast<size_t>(it - ranges.begin());
+                ranges.erase(it);
+                const std::uint64_t low = std::max(existing.first, interval.first);
+                const std::uint64_t high = std::min(existing.last, interval.last);
+
+                std::vector<Interval> parts;
+                Interval part;
+                const Interval& leading = existing.first < interval.first ? existing : interval;
+                if (leading.first < low && restrict(leading, leading.first, low - 1, part))
+                    parts.push_back(part);
+                Interval common[2];
+                const bool hasExisting = restrict(existing, low, high, common[0]);
+                const bool hasInterval = restrict(interval, low, high, common[1]);
+                if (!hasExisting || !hasInterval)
+                    parts.push_back(common[hasExisting ? 0 : 1]);
+                else if (common[0].step == 1 && common[0].first == low && common[0].last == high)
+                    parts.push_back(common[0]);
+                else if (common[1].step == 1 && common[1].first == low && common[1].last == high)
+                    parts.push_back(common[1]);
+                else if (common[0].step == common[1].step && common[0].first == common[1].first)
+                    parts.push_back(common[0]);
+                else
+                {
+                    std::vector<Interval> values;
+                    std::uint64_t next[2] = { common[0].first, common[1].first };
+                    bool more[2] = { true, true };
+                    while (more[0] || more[1])
+                    {
+                        const std::uint64_t value = !more[1] || (more[0] && next[0] <= next[1]) ? next[0] : next[1];
+                        append(values, { value, value, 1 }, true);
+                        for (int i = 0; i < 2; ++i)
+                        {
+                            if (!more[i] || next[i] != value)
+                                continue;
+                            if (next[i] == common[i].last)
+                                more[i] = false;
+                            else
+                                next[i] += common[i].step;
+                        }
+                    }
+                    parts.insert(parts.end(), values.begin(), values.end());
+                }
+                if (existing.last > high && restrict(existing, high + 1, existing.last, part))
+                    parts.push_back(part);
+                ranges.insert(ranges.begin() + static_cast<std::ptrdiff_t>(position), parts.begin(), parts.end());
+                // Values after the existing interval may overlap the next intervals
+                if (interval.last <= high || !restrict(interval, high + 1, interval.last, interval))
+                    return;
+            }
+        }
+
+        // Merges neighbouring intervals continuing each other
+        void normalize()
+        {
+            std::vector<Interval> merged;
+            merged.reserve(ranges.size());
+            for (const auto& interval : ranges)
+                append(merged, interval);
+            ranges.swap(merged);
+        }
+
+        std::vector<Interval> ranges;
+    };
+
+    namespace _detail
+    {
+        template <typename F, typename = void>
+        struct IsOptionFunction : std::false_type {};
+        template <typename F>
+        struct IsOptionFunction<F, decltype(void(std::declval<F&>()(std::declval<const Option&>())))> : std::true_type {};
+
+        // Move only callable stored in place, callables larger than the buffer or throwing on move are allocated
+        template <typename Signature>
+        class InplaceFunction;
+
+        template <typename R, typename... Args>
+        class InplaceFunction<R(Args...)>
+        {
+        public:
+            // Fits small lambdas and a std::function
+            static constexpr size_t Capacity = sizeof(std::function<R(Args...)>) > 6 * sizeof(void*) ? sizeof(std::function<R(Args...)>) : 6 * sizeof(void*);
+
+            InplaceFunction() = default;
+            template <typename F, typename Callable = typename std::decay<F>::type, typename = typename std::enable_if<!std::is_same<Callable, InplaceFunction>::value>::type>
+            InplaceFunction(F&& f)
+            {
+                store<Callable>(std::forward<F>(f), std::integral_constant<bool, sizeof(Callable) <= Capacity && alignof(Callable) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<Callable>::value>());
+            }
+            InplaceFunction(InplaceFunction&& other) noexcept { moveFrom(other); }
+            InplaceFunction& operator=(InplaceFunction&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    moveFrom(other);
+                }
+                return *this;
+            }
+            InplaceFunction(const InplaceFunction&) = delete;
+            ~InplaceFunction() { reset(); }
+
+            explicit operator bool() const { return invoker != nullptr; }
+            inline R operator()(Args... args) const { return invoker(&storage, std::forward<Args>(args)...); }
+
+        private:
+            template <typename Callable, typename F>
+            void store(F&& f, std::true_type /*inPlace*/)
+            {
+                ::new (static_cast<void*>(&storage)) Callable(std::forward<F>(f));
+                invoker = &invoke<Callable>;
+                manager = &manage<Callable>;
+            }
+            // The storage keeps the pointer to the allocated callable
+            template <typename Callable, typename F>
+            void store(F&& f, std::false_type /*inPlace*/)
+            {
+                ::new (static_cast<void*>(&storage)) Callable*(new Callable(std::forward<F>(f)));
+                invoker = &invokeAllocated<Callable>;
+                manager = &manageAllocated<Callable>;
+            }
+            template <typename Callable>
+            static R invoke(const void* callable, Args&&... args) { return (*static_cast<Callable*>(const_cast<void*>(callable)))(std::forward<Args>(args)...); }
+            template <typename Callable>
+            static R invokeAllocated(const void* callable, Args&&... args) { return (**static_cast<Callable* const*>(callable))(std::forward<Args>(args)...); }
+            template <typename Callable>
+            static void manageAllocated(void* destination, void* source)
+            {
+                if (source != nullptr)
+                    ::new (destination) Callable*(*static_cast<Callable**>(source));
+                else
+                    delete *static_cast<Callable**>(destination);
+            }
+            // Moves the callable from source to destination when source is given, destroys destination otherwise
+            template <typename Callable>
+            static void manage(void* destination, void* source)
+            {
+                if (source != nullptr)
+                {
+                    ::new (destination) Callable(std::move(*static_cast<Callable*>(source)));
+                    static_cast<Callable*>(source)->~Callable();
+                }
+                else
+                    static_cast<Callable*>(destination)->~Callable();
+            }
+            void moveFrom(InplaceFunction& other)
+            {
+                if (other.manager != nullptr)
+                    other.manager(&storage, &other.storage);
+                invoker = other.invoker;
+                manager = other.manager;
+                other.invoker = nullptr;
+                other.manager = nullptr;
+            }
+            void reset()
+            {
+                if (manager != nullptr)
+                    manager(&storage, nullptr);
+                invoker = nullptr;
+                manager = nullptr;
+            }
+
+            typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type storage;
+            R(*invoker)(const void*, Args&&...) = nullptr;
+            void(*manager)(void*, void*) = nullptr;
+        };
+
+        class FunctionExecutor
+        {
+        public:
+            template <typename F>
+            explicit FunctionExecutor(F&& onExists)
+                : f(std::forward<F>(onExists))
+            {}
+        protected:
+            InplaceFunction<void(const Option&)> f;
+        };
+
+        // Option holding the function as its concrete type, the call is resolved at compile time
+        template <typename Base, typename F>
+        class CallableOption
+            : public Base
+        {
+        public:
+            template <typename Function, typename... Args>
+            CallableOption(Function&& onExists, Args&&... args)
+                : Base(std::forward<Args>(args)...)
+                , f(std::forward<Function>(onExists))
+            {}
+            virtual void execute(const Option& option) const override { f(option); }
+        private:
+            mutable F f;
+        };
+    }
+    class FunctionOption
+        : public ValueOption
+        , protected _detail::FunctionExecutor
+    {
+    public:
+        template <typename F>
+        FunctionOption(ICli* po, _detail::StringRef parameter, F&& onExists, _detail::StringRef secondParameter = "", _detail::StringRef description = "", _detail::StringRef defaultValue = "", bool mandatory = false, size_t maxValueCount = SIZE_MAX)
+            : ValueOption(po, parameter, secondParameter, description, defaultValue, mandatory, maxValueCount)
+            , _detail::FunctionExecutor(std::forward<F>(onExists))
+        {}
+        virtual void execute(const Option& option) const override { f(option); }
+    };
+
+    class FunctionFlag
+        : public FlagOption
+        , protected _detail::FunctionExecutor
+    {
+    public:
+        template <typename F>
+        FunctionFlag(ICli* po, _detail::StringRef parameter, F&& onExists, _detail::StringRef description = "", _detail::StringRef secondParameter = "", bool mandatory = false)
+            : FlagOption(po, parameter, description, secondParameter, mandatory)
+            , _detail::FunctionExecutor(std::forward<F>(onExists))
+        {}
+        virtual void execute(const Option& option) const override { f(option); }
+    };
+
+    class FunctionMultiOption
+        : public MultiOption
+        , protected _detail::FunctionExecutor
+    {
+    public:
+        template <typename F>
+        FunctionMultiOption(ICli* po, _detail::StringRef parameter, F&& onExists, _detail::StringRef secondParameter = "", _detail::StringRef description = "", _detail::StringRef defaultValue = "", bool mandatory = false, size_t maxValueCount = SIZE_MAX)
+            : MultiOption(po, parameter, secondParameter, description, defaultValue, mandatory, maxValueCount)
+            , _detail::FunctionExecutor(std::forward<F>(onExists))
+        {}
+        virtual void execute(const Option& option) const override { f(option); }
+    };
+
+    class FunctionTaglessOption
+        : public TaglessOption
+        , protected _detail::FunctionExecutor
+    {
+    public:
+        template <typename F>
+        FunctionTaglessOption(ICli* po, F&& onExists, size_t valueCount = 1, _detail::StringRef description = "", _detail::StringRef defaultValue = "", bool mandatory = false)
+            : TaglessOption(po, valueCount, description, defaultValue, mandatory)
+            , _detail::FunctionExecutor(std::forward<F>(onExists))
+        {}
+        virtual void execute(const Option& option) const override { f(option); }
+    };
+
+    // Provides option values from outside of the command line such as configuration files.
+    // Keys are matched against option parameters as they are, with "--" or "-" prefixed,
+    // a section is joined to its keys with a dot: [server] threads = 4 -> --server.threads 4
+    class OptionSource
+    {
+    public:
+        // Views into the source, they need not be null terminated. The Cli copies the values it uses.
+        struct Entry
+        {
+            _detail::StringRef section;
+            _detail::StringRef key;
+            _detail::StringRef value;
+        };
+
+        OptionSource() = default;
+        OptionSource(const OptionSource&) = delete;
+        virtual ~OptionSource() = default;
+
+        virtual const std::vector<Entry>& entries() const = 0;
+    };
+
+    // Receives the duration of each parse phase and option function when BazPO_ENABLE_PARSE_TIMING is defined.
+    // Functions run by a parallel executor are reported from the threads running them.
+    class ParseObserver
+    {
+    public:
+        // Registration is the time from creating the Cli until parsing starts
+        enum class Phase { Registration, ParsePriority, ParseOptions, ApplySources, ValidateOptions, CheckMandatoryOptions, CrossCheckMultiConstraints, ExecuteExistingOptions, ExecutePriorityOptions, Count };
+
+        virtual ~ParseObserver() = default;
+        virtual void phase(Phase phase, std::chrono::nanoseconds duration) = 0;
+        virtual void callback(const Option& option, const char* parameter, std::chrono::nanoseconds duration) = 0;
+        // Evaluation of a constraint over valueCount values of the option, large value sets are reported in parts
+        virtual void constraint(const Option& /*option*/, const char* /*parameter*/, size_t /*valueCount*/, std::chrono::nanoseconds /*duration*/) {}
+        // Registration of an option after the observer was set, part of the registration phase
+        virtual void registration(const Option& /*option*/, const char* /*parameter*/, std::chrono::nanoseconds /*duration*/) {}
+
+        static const char* phaseName(Phase phase)
+        {
+            static const char* const names[] = { "registration", "parsePriority", "parseOptions", "applySources", "validateOptions", "checkMandatoryOptions",
+                "crossCheckMultiConstraints", "executeExistingOptions", "executePriorityOptions" };
+            return phase < Phase::Count ? names[static_cast<size_t>(phase)] : "";
+        }
+    };
+
+    namespace _detail
+    {
+        // Defined by the parser for its BazPO_ENABLE_PARSE_TIMING setting and called by the Cli constructor of the program.
+        // The setting changes the members of the Cli, a program linking BazPO::compiled built with the other setting fails to link instead of running a mismatching parser.
+#ifdef BazPO_ENABLE_PARSE_TIMING
+        void parserBuiltWithParseTiming();
+#define BazPO_CHECK_PARSER_BUILD() _detail::parserBuiltWithParseTiming()
+#else
+        void parserBuiltWithoutParseTiming();
+#define BazPO_CHECK_PARSER_BUILD() _detail::parserBuiltWithoutParseTiming()
+#endif
+    }
+
+#ifdef BazPO_ENABLE_PARSE_TIMING
+    // Sums the phase durations and keeps the duration of every option function
+    class ParseTimings
+        : public ParseObserver
+    {
+    public:
+        struct Callback
+        {
+            const Option* option;
+            const char* parameter;
+            std::chrono::nanoseconds duration;
+        };
+
+        virtual void phase(Phase phase, std::chrono::nanoseconds duration) override
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            phases[static_cast<size_t>(phase)] += duration;
+        }
+        virtual void callback(const Option& option, const char* parameter, std::chrono::nanoseconds duration) override
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            callbacks.push_back({ &option, parameter, duration });
+        }
+
+        inline std::chrono::nanoseconds duration(Phase phase) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return phases[static_cast<size_t>(phase)];
+        }
+        // Slowest option functions first
+        std::vector<Callback> slowestCallbacks(size_t count) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<Callback> slowest(callbacks);
+            count = std::min(count, slowest.size());
+            std::partial_sort(slowest.begin(), slowest.begin() + static_cast<std::ptrdiff_t>(count), slowest.end(), [](const Callback& l, const Callback& r) { return l.duration > r.duration; });
+            slowest.resize(count);
+            return slowest;
+        }
+
+    private:
+        mutable std::mutex mutex;
+        std::chrono::nanoseconds phases[static_cast<size_t>(Phase::Count)] = {};
+        std::vector<Callback> callbacks;
+    };
+
+    namespace _detail
+    {
+        class PhaseTimer
+        {
+        public:
+            PhaseTimer(ParseObserver* observer, ParseObserver::Phase phase)
+                : observer(observer)
+                , phase(phase)
+                , start(observer != nullptr ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+            {}
+            PhaseTimer(const PhaseTimer&) = delete;
+            ~PhaseTimer()
+            {
+                if (observer != nullptr)
+                    observer->phase(phase, std::chrono::steady_clock::now() - start);
+            }
+
+        private:
+            ParseObserver* observer;
+            ParseObserver::Phase phase;
+            std::chrono::steady_clock::time_point start;
+        };
+        class ConstraintTimer
+        {
+        public:
+            ConstraintTimer(ParseObserver* observer, const Option& option, const char* parameter, size_t valueCount)
+                : observer(observer)
+                , option(option)
+                , parameter(parameter)
+                , valueCount(valueCount)
+                , start(observer != nullptr ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+            {}
+            ConstraintTimer(const ConstraintTimer&) = delete;
+            ~ConstraintTimer()
+            {
+                if (observer != nullptr)
+                    observer->constraint(option, parameter, valueCount, std::chrono::steady_clock::now() - start);
+            }
+
+        private:
+            ParseObserver* observer;
+            const Option& option;
+            const char* parameter;
+            size_t valueCount;
+            std::chrono::steady_clock::time_point start;
+        };
+        // Reports the option registered while it lives, registering an existing key reports nothing
+        class RegistrationTimer
+        {
+        public:
+            RegistrationTimer(ParseObserver* observer, const std::vector<Option*>& options)
+                : observer(observer)
+                , options(options)
+                , count(options.size())
+                , start(observer != nullptr ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+            {}
+            RegistrationTimer(const RegistrationTimer&) = delete;
+            ~RegistrationTimer()
+            {
+                if (observer != nullptr && options.size() > count)
+                    observer->registration(*options.back(), options.back()->Parameter.c_str(), std::chrono::steady_clock::now() - start);
+            }
+
+        private:
+            ParseObserver* observer;
+            const std::vector<Option*>& options;
+            size_t count;
+            std::chrono::steady_clock::time_point start;
+        };
+    }
+#define BazPO_TIME_PHASE(phase) _detail::PhaseTimer phaseTimer(m_parseObserver, ParseObserver::Phase::phase)
+#define BazPO_TIME_CONSTRAINT(observer, option, valueCount) _detail::ConstraintTimer constraintTimer(observer, option, (option).Parameter.c_str(), valueCount)
+#define BazPO_TIME_REGISTRATION() _detail::RegistrationTimer registrationTimer(m_parseObserver, m_options)
+#else
+#define BazPO_TIME_PHASE(phase)
+#define BazPO_TIME_CONSTRAINT(observer, option, valueCount)
+#define BazPO_TIME_REGISTRATION()
+#endif
+
+    // Executes the functions of the existing options, a task only after the tasks it depends on.
+    // Tasks are in key order and only depend on tasks with existing options.
+    class CallbackExecutor
+    {
+    public:
+        struct Task
+        {
+            const Option* option;
+            std::vector<size_t> dependencies;
+#ifdef BazPO_ENABLE_PARSE_TIMING
+            ParseObserver* observer = nullptr;
+#endif
+        };
+
+        CallbackExecutor() = default;
+        CallbackExecutor(const CallbackExecutor&) = delete;
+        virtual ~CallbackExecutor() = default;
+
+        virtual void execute(const std::vector<Task>& tasks) = 0;
+        // Runs job(0) to job(count - 1), the jobs are independent of each other. Used to check the values of the options after parsing.
+        virtual void forEach(size_t count, const std::function<void(size_t)>& job)
+        {
+            for (size_t i = 0; i < count; ++i)
+                job(i);
+        }
+
+    protected:
+        static void run(const Task& task)
+        {
+#ifdef BazPO_ENABLE_PARSE_TIMING
+            if (task.observer != nullptr)
+            {
+                auto start = std::chrono::steady_clock::now();
+                task.option->execute(*task.option);
+                task.observer->callback(*task.option, task.option->Parameter.c_str(), std::chrono::steady_clock::now() - start);
+                return;
+            }
+#endif
+            task.option->execute(*task.option);
+        }
+        // Dependencies first, otherwise in task order
+        static std::vector<size_t> order(const std::vector<Task>& tasks)
+        {
+            enum class State : char { New, Visiting, Done };
+            std::vector<State> states(tasks.size(), State::New);
+            std::vector<size_t> ordered;
+            ordered.reserve(tasks.size());
+            std::function<void(size_t)> visit = [&](size_t index) {
+                if (states[index] == State::Done)
+                    return;
+                if (states[index] == State::Visiting)
+                    BazPO_THROW(_detail::CallbackDependencyCycle());
+                states[index] = State::Visiting;
+                for (auto dependency : tasks[index].dependencies)
+                    visit(dependency);
+                states[index] = State::Done;
+                ordered.push_back(index);
+            };
+            for (size_t i = 0; i < tasks.size(); ++i)
+                visit(i);
+            return ordered;
+        }
+    };
+
+    class SequentialExecutor
+        : public CallbackExecutor
+    {
+    public:
+        virtual void execute(const std::vector<Task>& tasks) override
+        {
+            for (auto index : order(tasks))
+                run(tasks[index]);
+        }
+    };
+
+    // Error found by Cli::tryParse(), the message is formatted only when asked for
+    struct Diagnostic
+    {
+        enum class Kind
+        {
+            UnexpectedArgument,
+            InvalidValue,
+            ConstraintViolation,
+            MultiConstraintViolation,
+            MissingMandatory,
+            AmbiguousOption
+        };
+
+        Kind kind;
+        // Index of the argument in argv, -1 when the error is not caused by an argument
+        int argIndex;
+        // Option of the error, null for unexpected arguments
+        const Option* option;
+        // Value causing the error, null when there is no value
+        const char* value;
+        const Constraint* constraint;
+        MultiConstraint* multiConstraint;
+        // Options an ambiguous abbreviation matches, separated by spaces
+        std::string candidates;
+
+        std::string message() const
+        {
+            std::string name = option == nullptr ? "" : (option->ParseType == _detail::OptionParseType::Unidentified ? option->description().str() : option->Parameter.str());
+            switch (kind)
+            {
+            case Kind::UnexpectedArgument:
+                return "Given value -> '" + std::string(value) + "' is not expected";
+            case Kind::InvalidValue:
+                return "Type of value '" + std::string(value) + "' is not expected for option " + name;
+            case Kind::ConstraintViolation:
+                return "Expected " + constraint->what() + " where -> '" + value + "' is not expected for option " + name;
+            case Kind::MultiConstraintViolation:
+                return multiConstraint->what();
+            case Kind::MissingMandatory:
+                return name + " is a required parameter";
+            case Kind::AmbiguousOption:
+                return "Option '" + std::string(value) + "' is ambiguous, possible options: " + candidates;
+            }
+            return "";
+        }
+    };
+
+    class ParseResult
+    {
+    public:
+        inline bool ok() const { return m_diagnostics.empty(); }
+        explicit operator bool() const { return ok(); }
+        inline const std::vector<Diagnostic>& diagnostics() const { return m_diagnostics; }
+        // The help option was given, help is printed without exiting
+        inline bool helpRequested() const { return m_helpRequested; }
+        // Messages of all diagnostics, one per line
+        std::string message() const
+        {
+            std::string messages;
+            for (const auto& diagnostic : m_diagnostics)
+                messages.append(diagnostic.message()).append("\n");
+            return messages;
+        }
+
+    private:
+        std::vector<Diagnostic> m_diagnostics;
+        bool m_helpRequested = false;
+
+        friend class Cli;
+    };
+
+    enum class Shell
+    {
+        Bash,
+        Zsh
+    };
+
+    class Cli
+        : public ICli
+    {
+    public:
+        Cli(int argc, const char* argv[], const char* programDescription = "")
+            : m_argc(argc)
+            , m_argEnd(argc)
+            , m_argv(argv)
+            , m_programDescription(programDescription)
+        {
+            BazPO_CHECK_PARSER_BUILD();
+#ifndef BazPO_DISABLE_AUTO_HELP_MESSAGE
+            flag("-h", [this](const Option&) { exitWithCode(0); }, "Prints this help message", "--help").prioritize();
+#endif
+        };
+        // Implementation of ICli
+        virtual Option& option(_detail::StringRef option, _detail::StringRef secondOption = "", _detail::StringRef description = "", _detail::StringRef defaultValue = "", OptionType optionType = OptionType::Value, size_t maxValueCount = SIZE_MAX) override;
+        virtual Option& option(_detail::StringRef option, const std::function<void(const Option&)>& onExists, _detail::StringRef secondOption = "", _detail::StringRef description = "", _detail::StringRef defaultValue = "", OptionType optionType = OptionType::Value, size_t maxValueCount = SIZE_MAX) override;
+        virtual Option& flag(_detail::StringRef option, _detail::StringRef description = "", _detail::StringRef secondOption = "") override;
+        virtual Option& flag(_detail::StringRef option, const std::function<void(const Option&)>& onExists, _detail::StringRef description = "", _detail::StringRef secondOption = "") override;
+        virtual Option& tagless(size_t valueCount = 1, _detail::StringRef description = "", _detail::StringRef defaultValue = "") override;
+        virtual Option& tagless(const std::function<void(const Option&)>& onExists, size_t valueCount = 1, _detail::StringRef description = "", _detail::StringRef defaultValue = "") override;
+        virtual void option(Option& option) override;
+        // Functions registered with their own type, neither stored in a std::function nor allocated separately
+        template <typename F, typename = typename std::enable_if<_detail::IsOptionFunction<F>::value>::type>
+        Option& option(_detail::StringRef option, F&& onExists, _detail::StringRef secondOption = "", _detail::StringRef description = "", _detail::StringRef defaultValue = "", OptionType optionType = OptionType::Value, size_t maxValueCount = SIZE_MAX);
+        template <typename F, typename = typename std::enable_if<_detail::IsOptionFunction<F>::value>::type>
+        Option& flag(_detail::StringRef option, F&& onExists, _detail::StringRef description = "", _detail::StringRef secondOption = "");
+        template <typename F, typename = typename std::enable_if<_detail::IsOptionFunction<F>::value>::type>
+        Option& tagless(F&& onExists, size_t valueCount = 1, _detail::StringRef description = "", _detail::StringRef defaultValue = "");
+        template <typename T>
+        TypedOption<T>& typedOption(_detail::StringRef option, _detail::StringRef secondOption = "", _detail::StringRef description = "", const T& defaultValue = T());
+        template <typename T>
+        TypedMultiOption<T>& typedMultiOption(_detail::StringRef option, _detail::StringRef secondOption = "", _detail::StringRef description = "", std::vector<T> defaultValues = {}, size_t maxValueCount = SIZE_MAX);
+        virtual Option& prioritize(_detail::StringRef key) final
+        {
+            auto& option = m_refMap.at(getKey(key));
+            if (option.ParseType == _detail::OptionParseType::Unidentified)
+                BazPO_THROW(_detail::PrioritizationOptionMismatch());
+
+            // Key of the registered option, the given key may not outlive this
+            m_priorityMap.emplace(m_refMap.find(getKey(key))->first, option);
+            option.Prioritized = true;
+            return option;
+        };
+        virtual Option& mandatory(_detail::StringRef key) final { return m_refMap.at(getKey(key)).mandatory(); }
+        inline const Option& getOption(_detail::StringRef option) const { return m_refMap.at(getKey(option)); }
+        template <typename T>
+        inline T valueAs(_detail::StringRef option) const { return m_refMap.at(getKey(option)).valueAs<T>(); }
+        inline bool exists(_detail::StringRef option) const { return m_refMap.at(getKey(option)).Exists; }
+        inline bool existsCount(_detail::StringRef option) const { return m_refMap.at(getKey(option)).ExistsCount; }
+        inline OptionHandle handle(_detail::StringRef option) const { return m_refMap.at(getKey(option)).Handle; }
+        // Accessors of handles index the registered options
+        inline const Option& getOption(OptionHandle option) const { return *m_options[option.index]; }
+        template <typename T>
+        inline T valueAs(OptionHandle option) const { return m_options[option.index]->valueAs<T>(); }
+        inline bool exists(OptionHandle option) const { return m_options[option.index]->Exists; }
+        inline int existsCount(OptionHandle option) const { return m_options[option.index]->ExistsCount; }
+        void askInput(Option& option);
+        inline void askInput(_detail::StringRef key) { askInput(m_refMap.at(getKey(key))); }
+        void printOptions();
+        void parse();
+        // Parses without exiting the program, every error is returned instead of ending the program at the first one.
+        // Option functions are not executed when there are errors.
+        ParseResult tryParse();
+#ifndef BazPO_DISABLE_IOSTREAM
+        inline void changeIO(std::ostream* ostream, std::istream* istream = &std::cin) { m_output.redirect(ostream); m_input.redirect(istream); }
+#endif
+        // Printed text is passed to the write function, the only output available when BazPO_DISABLE_IOSTREAM is defined
+        inline void output(WriteFunction write, void* context = nullptr) { m_output.redirect(write, context); }
+        inline void input(ReadLineFunction readLine, void* context = nullptr) { m_input.redirect(readLine, context); }
+        inline void userInputRequired() { m_askInputForMandatoryOptions = true; }
+        inline void unexpectedArgumentsAcceptable() { m_exitOnUnexpectedValue = false; }
+        // Long options can be given by a unique prefix of their name, --verb for --verbose
+        inline void abbreviationsAcceptable() { m_abbreviations = true; }
+        // Parsing only checks the arguments and sources, the option functions of this Cli and its subcommands are not executed
+        inline void functionsDisabled() { m_executeFunctions = false; }
+        // Values from sources are used for options that are not given in the arguments, later sources take precedence
+        inline void source(const std::shared_ptr<const OptionSource>& source) { m_sources.emplace_back(source); }
+        // Executes the option functions after parsing, functions are executed sequentially by default
+        inline void callbackExecutor(const std::shared_ptr<CallbackExecutor>& executor) { m_callbackExecutor = executor; }
+#ifdef BazPO_ENABLE_PARSE_TIMING
+        // Times the parse phases and option functions of this Cli and the selected subcommand
+        inline void observe(ParseObserver& observer) { m_parseObserver = &observer; }
+#endif
+        Option& dependency(_detail::StringRef key, const std::string& dependsOn) { return m_refMap.at(getKey(key)).dependsOn(dependsOn); }
+        // Options of a subcommand are registered only when the subcommand is selected by the arguments,
+        // arguments before the subcommand are parsed by this Cli and the rest by the subcommand Cli
+        void subcommand(const std::string& name, const std::function<void(Cli&)>& registerOptions, const std::string& description = "");
+        inline Cli* selectedSubcommand() const { return m_selectedSubcommand.get(); }
+        inline const char* selectedSubcommandName() const { return m_selectedSubcommand ? m_argv[m_argEnd] : ""; }
+        // Candidates for the last word, one per line, the words exclude the program name
+        std::string completions(int wordCount, const char* words[]);
+        std::string completionScript(Shell shell) const;
+        template<typename... Options>
+        MutuallyExclusive& mutuallyExclusive(Options&... options) { m_multiConstraintStorage.emplace_back(std::make_shared<MutuallyExclusive>(this, m_refMap.at(getKey(options))...)); return reinterpret_cast<MutuallyExclusive&>(*m_multiConstraintStorage.back()); }
+        Option& constraint(_detail::StringRef key, std::deque<std::string> stringConstraints) { return m_refMap.at(getKey(key)).constrain(stringConstraints); };
+        template<typename T>
+        Option& constraint(_detail::StringRef key, std::pair<T, T> minMaxConstraints) { return m_refMap.at(getKey(key)).constrain<T>(minMaxConstraints); };
+        Option& constraint(_detail::StringRef key, const std::function<bool(const Option&)>& isSatisfied, const std::string& errorMessage) { return m_refMap.at(getKey(key)).constrain(isSatisfied, errorMessage); };
+
+    private:
+        virtual void conversionError(const Option& option, const char* value) override;
+        virtual void exitWithCode(int code) override
+        {
+            printOptions();
+            if (m_result == nullptr)
+                exit(code);
+            m_result->m_helpRequested = m_result->m_helpRequested || code == 0;
+        };
+        virtual void printOptionUsage(const Option& option) override;
+        virtual void printOption(const Option& option) override;
+        virtual std::string parameterSyntax(const std::string& value, bool mandatory) const override;
+        std::string sizeSyntax(size_t value) const;
+
+        void readArguments();
+        void executeFunctions() const;
+        bool report(Diagnostic::Kind kind, const Option* option, const char* value, const Constraint* constraint = nullptr, MultiConstraint* multiConstraint = nullptr, std::string candidates = std::string());
+        void selectSubcommand();
+        bool priorityRequested();
+        void indexShortOptions();
+        void indexLongOptions();
+        Option* abbreviatedOption(_detail::StringRef prefix);
+        std::string abbreviationCandidates(const char* argument);
+        bool splitArgument(const char* argument, std::vector<std::pair<Option*, const char*>>& options);
+        bool completionRequested();
+        std::string programName() const;
+        void parsePriority();
+        void parseOptions();
+        void applySources();
+        Option* findSourceOption(const OptionSource::Entry& entry, std::string& name) const;
+        bool sourceSection(_detail::StringRef section, _detail::StringRef& relative) const;
+        void checkMandatoryOptions();
+        void crossCheckMultiConstraints();
+        void validateOptions();
+        void checkDependencies() const;
+        void validate(const std::vector<Option*>& options);
+        int argumentIndex(const char* value) const;
+        void addValue(Option& option, const char* value);
+        inline void executeExistingOptions() const;
+        inline void executePriorityOptions() const;
+        void executeOptions(const std::map<_detail::StringRef, Option&>& options) const;
+        // Refers to the given option when it is not an alias, keep the option alive while using the key
+        inline _detail::StringRef getKey(_detail::StringRef option) const
+        {
+            auto alias = m_aliasMap.find(option);
+            return alias != m_aliasMap.end() ? alias->second : option;
+        }
+        virtual _detail::StringRef intern(_detail::StringRef text) override { return m_strings.intern(text); }
+        void measureOptions();
+        void registerAlias(_detail::StringRef option, _detail::StringRef secondOption);
+        void registerOption(_detail::StringRef key, Option& option);
+        void unknownArgParsingError(const std::string& value);
+        void constraintError(const std::string& constraints, const std::string& value, const std::string& parameter);
+        void multiConstraintError(const std::string& message);
+        void ambiguousOptionError(const std::string& value, const std::string& candidates);
+
+        // Widths of the printed columns, measured when printing after options were registered
+        size_t m_maxOptionParameterSize = 0;
+        size_t m_maxSecondOptionParameterSize = 0;
+        bool m_optionsMeasured = false;
+        const int m_argc;
+        int m_argEnd;
+        const char** m_argv;
+        const char* m_programDescription;
+
+        // Names and descriptions given as dynamic strings, outlives the options referring to them
+        _detail::StringPool m_strings;
+        std::deque<std::shared_ptr<Option>> m_optionStorage;
+        std::deque<std::shared_ptr<MultiConstraint>> m_multiConstraintStorage;
+        std::map<_detail::StringRef, Option&> m_refMap;
+        // Registered options by handle
+        std::vector<Option*> m_options;
+        std::map<_detail::StringRef, Option&> m_priorityMap;
+        std::map<_detail::StringRef, _detail::StringRef> m_aliasMap;
+        // Single character options by their character, -x -> m_shortOptions['x']
+        Option* m_shortOptions[256] = {};
+        bool m_shortOptionsIndexed = false;
+        // Long options and their aliases by prefix, built on the first abbreviation
+        _detail::PrefixIndex m_longOptions;
+        bool m_longOptionsIndexed = false;
+        // Collects the errors instead of exiting while in tryParse()
+        ParseResult* m_result = nullptr;
+        int m_argIndex = -1;
+        int m_argOffset = 0;
+        std::deque<std::string> m_inputStorage;
+        std::deque<std::shared_ptr<const OptionSource>> m_sources;
+        // Section of the sources holding the keys of this Cli, the subcommand names leading to it
+        std::string m_sourceSection;
+        struct Subcommand
+        {
+            std::function<void(Cli&)> registerOptions;
+            std::string description;
+        };
+        std::map<std::string, Subcommand> m_subcommands;
+        std::unique_ptr<Cli> m_selectedSubcommand;
+        std::shared_ptr<CallbackExecutor> m_callbackExecutor;
+#ifdef BazPO_ENABLE_PARSE_TIMING
+        ParseObserver* m_parseObserver = nullptr;
+        std::chrono::steady_clock::time_point m_created = std::chrono::steady_clock::now();
+#endif
+        // Option functions run by a parallel executor report conversion errors concurrently
+        std::mutex m_reportMutex;
+        bool m_parsed = false;
+        bool m_parsedPriority = false;
+        bool m_askInputForMandatoryOptions = false;
+        bool m_exitOnUnexpectedValue = true;
+        bool m_abbreviations = false;
+        bool m_executeFunctions = true;
+
+        _detail::Input m_input;
+        _detail::Output m_output;
+
+        friend class _detail::Serializer;
+    };
+
+    template <typename F, typename>
+    Option& Cli::option(_detail::StringRef option, F&& onExists, _detail::StringRef secondOption, _detail::StringRef description, _detail::StringRef defaultValue, OptionType optionType, size_t maxValueCount)
+    {
+        BazPO_TIME_REGISTRATION();
+        option = intern(option);
+        secondOption = intern(secondOption);
+        description = intern(description);
+        defaultValue = intern(defaultValue);
+        using Function = typename std::decay<F>::type;
+        if (optionType == OptionType::MultiValue)
+            m_optionStorage.emplace_back(std::make_shared<_detail::CallableOption<MultiOption, Function>>(std::forward<F>(onExists), nullptr, option, secondOption, description, defaultValue, false, maxValueCount));
+        else
+            m_optionStorage.emplace_back(std::make_shared<_detail::CallableOption<ValueOption, Function>>(std::forward<F>(onExists), nullptr, option, secondOption, description, defaultValue, false, maxValueCount));
+
+        registerOption(option, *m_optionStorage.back());
+        registerAlias(option, secondOption);
+        return *m_optionStorage.back();
+    }
+
+    template <typename F, typename>
+    Option& Cli::flag(_detail::StringRef option, F&& onExists, _detail::StringRef description, _detail::StringRef secondOption)
+    {
+        BazPO_TIME_REGISTRATION();
+        option = intern(option);
+        description = intern(description);
+        secondOption = intern(secondOption);
+        m_optionStorage.emplace_back(std::make_shared<_detail::CallableOption<FlagOption, typename std::decay<F>::type>>(std::forward<F>(onExists), nullptr, option, description, secondOption, false));
+        registerOption(option, *m_optionStorage.back());
+        registerAlias(option, secondOption);
+        return *m_optionStorage.back();
+    }
+
+    template <typename F, typename>
+    Option& Cli::tagless(F&& onExists, size_t valueCount, _detail::StringRef description, _detail::StringRef defaultValue)
+    {
+        BazPO_TIME_REGISTRATION();
+        description = intern(description);
+        defaultValue = intern(defaultValue);
+        m_optionStorage.emplace_back(std::make_shared<_detail::CallableOption<TaglessOption, typename std::decay<F>::type>>(std::forward<F>(onExists), nullptr, valueCount, description, defaultValue, false));
+        registerOption(intern(std::to_string(getNextId())), *m_optionStorage.back());
+        return *m_optionStorage.back();
+    }
+
+    template <typename T>
+    TypedOption<T>& Cli::typedOption(_detail::StringRef option, _detail::StringRef secondOption, _detail::StringRef description, const T& defaultValue)
+    {
+        BazPO_TIME_REGISTRATION();
+        option = intern(option);
+        secondOption = intern(secondOption);
+        description = intern(description);
+        auto typed = std::make_shared<TypedOption<T>>(nullptr, option, secondOption, description, defaultValue, false);
+        m_optionStorage.emplace_back(typed);
+        registerOption(option, *typed);
+        registerAlias(option, secondOption);
+        return *typed;
+    }
+
+    template <typename T>
+    TypedMultiOption<T>& Cli::typedMultiOption(_detail::StringRef option, _detail::StringRef secondOption, _detail::StringRef description, std::vector<T> defaultValues, size_t maxValueCount)
+    {
+        BazPO_TIME_REGISTRATION();
+        option = intern(option);
+        secondOption = intern(secondOption);
+        description = intern(description);
+        auto typed = std::make_shared<TypedMultiOption<T>>(nullptr, option, secondOption, description, std::move(defaultValues), false, maxValueCount);
+        m_optionStorage.emplace_back(typed);
+        registerOption(option, *typed);
+        registerAlias(option, secondOption);
+        return *typed;
+    }
+
+    // Typed options of the common types are instantiated once in BazPO::compiled
+#define BazPO_INSTANTIATE_TYPED_OPTIONS(prefix, T) \
+    prefix template class TypedOption<T>; \
+    prefix template class TypedMultiOption<T>; \
+    prefix template TypedOption<T>& Cli::typedOption<T>(_detail::StringRef, _detail::StringRef, _detail::StringRef, const T&); \
+    prefix template TypedMultiOption<T>& Cli::typedMultiOption<T>(_detail::StringRef, _detail::StringRef, _detail::StringRef, std::vector<T>, size_t);
+#define BazPO_INSTANTIATE_NUMBER(prefix, T) \
+    prefix template std::pair<T, bool> _detail::valueAs<T>(const std::string&); \
+    BazPO_INSTANTIATE_TYPED_OPTIONS(prefix, T)
+#define BazPO_INSTANTIATE_ALL(prefix) \
+    BazPO_INSTANTIATE_NUMBER(prefix, int) \
+    BazPO_INSTANTIATE_NUMBER(prefix, long) \
+    BazPO_INSTANTIATE_NUMBER(prefix, long long) \
+    BazPO_INSTANTIATE_NUMBER(prefix, unsigned) \
+    BazPO_INSTANTIATE_NUMBER(prefix, unsigned long) \
+    BazPO_INSTANTIATE_NUMBER(prefix, unsigned long long) \
+    BazPO_INSTANTIATE_NUMBER(prefix, float) \
+    BazPO_INSTANTIATE_NUMBER(prefix, double) \
+    BazPO_INSTANTIATE_TYPED_OPTIONS(prefix, std::string)
+
+#ifdef BazPO_COMPILED
+    BazPO_INSTANTIATE_ALL(extern)
+#endif
+}
+
+#endif
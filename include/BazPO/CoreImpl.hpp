@@ -0,0 +1,1075 @@
+#ifndef BAZ_PO_CORE_IMPL_HPP
+#define BAZ_PO_CORE_IMPL_HPP
+
+/*
+BazPO parser definitions.
+Copyright (c) 2022 Baris Tanyeri
+https://github.com/karusb/BazPO
+MIT License
+*/
+
+#include "Core.hpp"
+
+// Definitions are inline in the header only build, src/BazPO.cpp compiles them once for BazPO::compiled
+#ifndef BazPO_INLINE
+#define BazPO_INLINE inline
+#endif
+
+namespace BazPO
+{
+#ifdef BazPO_ENABLE_PARSE_TIMING
+    BazPO_INLINE void _detail::parserBuiltWithParseTiming() {}
+#else
+    BazPO_INLINE void _detail::parserBuiltWithoutParseTiming() {}
+#endif
+
+    BazPO_INLINE Option& Option::constrain(std::deque<std::string> stringConstraints) { ConstraintStorage.emplace_back(std::make_shared<StringConstraint>(*this, stringConstraints)); return *this; }
+    BazPO_INLINE Option& Option::constrain(const std::function<bool(const Option&)>& isSatisfied, const std::string& errorMessage) { ConstraintStorage.emplace_back(std::make_shared<FunctionConstraint>(*this, isSatisfied, errorMessage)); return *this; }
+    BazPO_INLINE void Option::complete(const char* prefix, std::string& candidates) const
+    {
+        for (const auto& constraint : Constrained)
+            constraint->complete(prefix, candidates);
+    }
+
+    BazPO_INLINE Option& Cli::option(_detail::StringRef option, _detail::StringRef secondOption, _detail::StringRef description, _detail::StringRef defaultValue, OptionType optionType, size_t maxValueCount)
+    {
+        BazPO_TIME_REGISTRATION();
+        option = intern(option);
+        secondOption = intern(secondOption);
+        description = intern(description);
+        defaultValue = intern(defaultValue);
+        if (optionType == OptionType::MultiValue)
+            m_optionStorage.emplace_back(std::make_shared<MultiOption>(nullptr, option, secondOption, description, defaultValue, false, maxValueCount));
+        else
+            m_optionStorage.emplace_back(std::make_shared<ValueOption>(nullptr, option, secondOption, description, defaultValue, false, maxValueCount));
+
+        registerOption(option, *m_optionStorage.back());
+        registerAlias(option, secondOption);
+        return *m_optionStorage.back();
+    }
+
+    BazPO_INLINE Option& Cli::option(_detail::StringRef option, const std::function<void(const Option&)>& onExists, _detail::StringRef secondOption, _detail::StringRef description, _detail::StringRef defaultValue, OptionType optionType, size_t maxValueCount)
+    {
+        BazPO_TIME_REGISTRATION();
+        option = intern(option);
+        secondOption = intern(secondOption);
+        description = intern(description);
+        defaultValue = intern(defaultValue);
+        if (optionType == OptionType::MultiValue)
+            m_optionStorage.emplace_back(std::make_shared<FunctionMultiOption>(nullptr, option, onExists, secondOption, description, defaultValue, false, maxValueCount));
+        else
+            m_optionStorage.emplace_back(std::make_shared<FunctionOption>(nullptr, option, onExists, secondOption, description, defaultValue, false, maxValueCount));
+
+        registerOption(option, *m_optionStorage.back());
+        registerAlias(option, secondOption);
+        return *m_optionStorage.back();
+    }
+
+    BazPO_INLINE Option& Cli::flag(_detail::StringRef option, _detail::StringRef description, _detail::StringRef secondOption)
+    {
+        BazPO_TIME_REGISTRATION();
+        option = intern(option);
+        description = intern(description);
+        secondOption = intern(secondOption);
+        m_optionStorage.emplace_back(std::make_shared<FlagOption>(nullptr, option, description, secondOption, false));
+        registerOption(option, *m_optionStorage.back());
+        registerAlias(option, secondOption);
+        return *m_optionStorage.back();
+    }
+
+    BazPO_INLINE Option& Cli::flag(_detail::StringRef option, const std::function<void(const Option&)>& onExists, _detail::StringRef description, _detail::StringRef secondOption)
+    {
+        BazPO_TIME_REGISTRATION();
+        option = intern(option);
+        description = intern(description);
+        secondOption = intern(secondOption);
+        m_optionStorage.emplace_back(std::make_shared<FunctionFlag>(nullptr, option, onExists, description, secondOption, false));
+        registerOption(option, *m_optionStorage.back());
+        registerAlias(option, secondOption);
+        return *m_optionStorage.back();
+    }
+
+    BazPO_INLINE Option& Cli::tagless(size_t valueCount, _detail::StringRef description, _detail::StringRef defaultValue)
+    {
+        BazPO_TIME_REGISTRATION();
+        description = intern(description);
+        defaultValue = intern(defaultValue);
+        m_optionStorage.emplace_back(std::make_shared<TaglessOption>(nullptr, valueCount, description, defaultValue, false));
+        registerOption(intern(std::to_string(getNextId())), *m_optionStorage.back());
+        return *m_optionStorage.back();
+    }
+
+    BazPO_INLINE Option& Cli::tagless(const std::function<void(const Option&)>& onExists, size_t valueCount, _detail::StringRef description, _detail::StringRef defaultValue)
+    {
+        BazPO_TIME_REGISTRATION();
+        description = intern(description);
+        defaultValue = intern(defaultValue);
+        m_optionStorage.emplace_back(std::make_shared<FunctionTaglessOption>(nullptr, onExists, valueCount, description, defaultValue, false));
+        registerOption(intern(std::to_string(getNextId())), *m_optionStorage.back());
+        return *m_optionStorage.back();
+    }
+
+    BazPO_INLINE void Cli::option(Option& option)
+    {
+        BazPO_TIME_REGISTRATION();
+        registerOption(option.Parameter, option);
+        registerAlias(option.Parameter, option.SecondParameter);
+    }
+
+    BazPO_INLINE void Cli::subcommand(const std::string& name, const std::function<void(Cli&)>& registerOptions, const std::string& description)
+    {
+        m_subcommands[name] = { registerOptions, description };
+        m_optionsMeasured = false;
+    }
+
+    BazPO_INLINE void Cli::parse()
+    {
+        if (m_parsed)
+            return;
+#ifndef BazPO_DISABLE_COMPLETION
+        if (m_result == nullptr && completionRequested())
+            exit(0);
+#endif
+#ifdef BazPO_ENABLE_PARSE_TIMING
+        if (m_parseObserver != nullptr)
+            m_parseObserver->phase(ParseObserver::Phase::Registration, std::chrono::steady_clock::now() - m_created);
+#endif
+
+        readArguments();
+        executeFunctions();
+    }
+
+    BazPO_INLINE ParseResult Cli::tryParse()
+    {
+        ParseResult result;
+        m_result = &result;
+        parse();
+        for (Cli* cli = this; cli != nullptr; cli = cli->m_selectedSubcommand.get())
+            cli->m_result = nullptr;
+        // Argument order, errors not caused by an argument last
+        std::stable_sort(result.m_diagnostics.begin(), result.m_diagnostics.end(), [](const Diagnostic& l, const Diagnostic& r) {
+            return static_cast<unsigned>(l.argIndex) < static_cast<unsigned>(r.argIndex);
+        });
+        return result;
+    }
+
+    // Parses the arguments of this and the selected subcommand before any function is executed
+    BazPO_INLINE void Cli::readArguments()
+    {
+        selectSubcommand();
+        if (m_selectedSubcommand)
+        {
+            m_selectedSubcommand->m_result = m_result;
+            m_selectedSubcommand->m_argOffset = m_argOffset + m_argEnd;
+#ifdef BazPO_ENABLE_PARSE_TIMING
+            m_selectedSubcommand->m_parseObserver = m_parseObserver;
+#endif
+        }
+        checkDependencies();
+        parsePriority();
+        m_argIndex = -1;
+        m_parsed = true;
+        // Prioritized options of the subcommand are handled before the rest of the arguments
+        if (!m_parsedPriority && m_selectedSubcommand && m_selectedSubcommand->priorityRequested())
+            m_selectedSubcommand->readArguments();
+        else if (!m_parsedPriority)
+        {
+            parseOptions();
+            applySources();
+            validateOptions();
+            checkMandatoryOptions();
+            crossCheckMultiConstraints();
+            if (m_selectedSubcommand)
+                m_selectedSubcommand->readArguments();
+        }
+    }
+
+    BazPO_INLINE void Cli::executeFunctions() const
+    {
+        if (!m_executeFunctions || (m_result != nullptr && !m_result->ok()))
+            return;
+        if (m_parsedPriority)
+        {
+            executePriorityOptions();
+            return;
+        }
+        executeExistingOptions();
+        if (m_selectedSubcommand)
+            m_selectedSubcommand->executeFunctions();
+    }
+
+    // Records the error while in tryParse(), otherwise the caller ends the program
+    BazPO_INLINE bool Cli::report(Diagnostic::Kind kind, const Option* option, const char* value, const Constraint* constraint, MultiConstraint* multiConstraint, std::string candidates)
+    {
+        if (m_result == nullptr)
+            return false;
+        auto& diagnostics = m_result->m_diagnostics;
+        // Multi constraints are checked for each of their options
+        if (multiConstraint != nullptr && std::any_of(diagnostics.begin(), diagnostics.end(), [multiConstraint](const Diagnostic& d) { return d.multiConstraint == multiConstraint; }))
+            return true;
+        diagnostics.push_back({ kind, m_argIndex < 0 ? -1 : m_argIndex + m_argOffset, option, value, constraint, multiConstraint, std::move(candidates) });
+        return true;
+    }
+
+    BazPO_INLINE void Cli::selectSubcommand()
+    {
+        if (m_subcommands.empty())
+            return;
+        std::vector<std::pair<Option*, const char*>> split;
+        for (int i = 1; i < m_argc; ++i)
+        {
+            auto option = m_refMap.find(getKey(m_argv[i]));
+            if (option != m_refMap.end())
+            {
+                // Value of the option can not be a subcommand
+                if (option->second.MaxValueCount > 0 && option->second.ParseType == _detail::OptionParseType::Value)
+                    ++i;
+                continue;
+            }
+            if (splitArgument(m_argv[i], split))
+            {
+                if (split.back().second == nullptr && split.back().first->MaxValueCount > 0 && split.back().first->ParseType == _detail::OptionParseType::Value)
+                    ++i;
+                continue;
+            }
+            auto subcommand = m_subcommands.find(m_argv[i]);
+            if (subcommand == m_subcommands.end())
+                continue;
+
+            m_argEnd = i;
+            m_selectedSubcommand = std::make_unique<Cli>(m_argc - i, m_argv + i, subcommand->second.description.c_str());
+            m_selectedSubcommand->m_output = m_output;
+            m_selectedSubcommand->m_input = m_input;
+            m_selectedSubcommand->m_askInputForMandatoryOptions = m_askInputForMandatoryOptions;
+            m_selectedSubcommand->m_exitOnUnexpectedValue = m_exitOnUnexpectedValue;
+            m_selectedSubcommand->m_abbreviations = m_abbreviations;
+            m_selectedSubcommand->m_callbackExecutor = m_callbackExecutor;
+            m_selectedSubcommand->m_sources = m_sources;
+            m_selectedSubcommand->m_sourceSection = m_sourceSection.empty() ? subcommand->first : m_sourceSection + "." + subcommand->first;
+            subcommand->second.registerOptions(*m_selectedSubcommand);
+            return;
+        }
+    }
+    // Hidden completion mode, answered from the registered options without parsing the arguments
+    // program __complete <words...>    -> candidates for the last word
+    // program __completion bash|zsh    -> completion script calling __complete
+    BazPO_INLINE bool Cli::completionRequested()
+    {
+        if (m_argc < 2)
+            return false;
+        std::string output;
+        if (std::strcmp(m_argv[1], "__complete") == 0)
+            output = completions(m_argc - 2, m_argv + 2);
+        else if (std::strcmp(m_argv[1], "__completion") == 0 && m_argc > 2)
+            output = completionScript(std::strcmp(m_argv[2], "zsh") == 0 ? Shell::Zsh : Shell::Bash);
+        else
+            return false;
+        m_output << output;
+        m_output.flush();
+        return true;
+    }
+
+    BazPO_INLINE std::string Cli::completions(int wordCount, const char* words[])
+    {
+        std::string candidates;
+        const char* prefix = wordCount > 0 ? words[wordCount - 1] : "";
+        for (int i = 0; i < wordCount - 1; ++i)
+        {
+            auto option = m_refMap.find(getKey(words[i]));
+            if (option != m_refMap.end())
+            {
+                if (option->second.MaxValueCount > 0 && option->second.ParseType == _detail::OptionParseType::Value)
+                    ++i;
+                continue;
+            }
+            auto subcommand = m_subcommands.find(words[i]);
+            if (subcommand != m_subcommands.end())
+            {
+                Cli cli(wordCount - i, words + i, "");
+                subcommand->second.registerOptions(cli);
+                return cli.completions(wordCount - i - 1, words + i + 1);
+            }
+        }
+
+        if (wordCount > 1)
+        {
+            auto previous = m_refMap.find(getKey(words[wordCount - 2]));
+            if (previous != m_refMap.end() && previous->second.MaxValueCount > 0 && previous->second.ParseType != _detail::OptionParseType::Unidentified)
+            {
+                previous->second.complete(prefix, candidates);
+                if (!candidates.empty() || *prefix != '-')
+                    return candidates;
+            }
+        }
+
+        const size_t prefixSize = std::strlen(prefix);
+        auto append = [&](const std::string& candidate) {
+            if (!candidate.empty() && candidate.compare(0, prefixSize, prefix) == 0)
+                candidates.append(candidate).append("\n");
+        };
+        for (const auto& pair : m_refMap)
+        {
+            if (pair.second.ParseType == _detail::OptionParseType::Unidentified)
+                continue;
+            append(pair.second.Parameter);
+            append(pair.second.SecondParameter);
+        }
+        for (const auto& pair : m_subcommands)
+            append(pair.first);
+        return candidates;
+    }
+
+    BazPO_INLINE std::string Cli::completionScript(Shell shell) const
+    {
+        auto name = programName();
+        auto function = std::string("_bazpo_") + name;
+        std::replace_if(function.begin(), function.end(), [](char c) { return !std::isalnum(static_cast<unsigned char>(c)); }, '_');
+
+        std::string script;
+        if (shell == Shell::Zsh)
+        {
+            script.append("#compdef ").append(name).append("\n")
+                .append(function).append("()\n{\n")
+                .append("    local -a candidates\n")
+                .append("    candidates=(\"${(@f)$(").append(name).append(" __complete \"${(@)words[2,CURRENT]}\" 2>/dev/null)}\")\n")
+                .append("    if [[ -n \"${candidates[1]}\" ]]; then\n        compadd -a candidates\n    else\n        _files\n    fi\n}\n")
+                .append("compdef ").append(function).append(" ").append(name).append("\n");
+        }
+        else
+        {
+            script.append(function).append("()\n{\n")
+                .append("    local IFS=$'\\n'\n")
+                .append("    COMPREPLY=($(").append(name).append(" __complete \"${COMP_WORDS[@]:1:COMP_CWORD}\" 2>/dev/null))\n}\n")
+                .append("complete -o default -F ").append(function).append(" ").append(name).append("\n");
+        }
+        return script;
+    }
+
+    BazPO_INLINE bool Cli::priorityRequested()
+    {
+        std::vector<std::pair<Option*, const char*>> split;
+        for (int i = 1; i < m_argEnd; ++i)
+        {
+            if (m_priorityMap.find(getKey(m_argv[i])) != m_priorityMap.end())
+                return true;
+            if (m_refMap.find(getKey(m_argv[i])) == m_refMap.end() && splitArgument(m_argv[i], split))
+                for (const auto& part : split)
+                    if (part.first->Prioritized)
+                        return true;
+        }
+        return false;
+    }
+
+    BazPO_INLINE void Cli::indexShortOptions()
+    {
+        if (m_shortOptionsIndexed)
+            return;
+        m_shortOptionsIndexed = true;
+        auto index = [this](_detail::StringRef key, Option& option) {
+            if (key.size() == 2 && key.c_str()[0] == '-' && key.c_str()[1] != '-')
+                m_shortOptions[static_cast<unsigned char>(key.c_str()[1])] = &option;
+        };
+        for (auto& pair : m_refMap)
+            index(pair.first, pair.second);
+        for (const auto& pair : m_aliasMap)
+        {
+            auto option = m_refMap.find(pair.second);
+            if (option != m_refMap.end())
+                index(pair.first, option->second);
+        }
+    }
+
+    BazPO_INLINE void Cli::indexLongOptions()
+    {
+        if (m_longOptionsIndexed)
+            return;
+        m_longOptionsIndexed = true;
+        auto isLong = [](_detail::StringRef key) { return key.size() > 2 && key.c_str()[0] == '-' && key.c_str()[1] == '-'; };
+        std::vector<_detail::PrefixIndex::Name> names;
+        for (auto& pair : m_refMap)
+            if (isLong(pair.first))
+                names.push_back({ pair.first, &pair.second });
+        for (const auto& pair : m_aliasMap)
+        {
+            auto option = m_refMap.find(pair.second);
+            if (isLong(pair.first) && option != m_refMap.end())
+                names.push_back({ pair.first, &option->second });
+        }
+        m_longOptions.build(std::move(names));
+    }
+
+    // Option of a long option prefix when abbreviations are acceptable, null when no option or more than one option starts with it
+    BazPO_INLINE Option* Cli::abbreviatedOption(_detail::StringRef prefix)
+    {
+        if (!m_abbreviations || prefix.size() <= 2)
+            return nullptr;
+        indexLongOptions();
+        return m_longOptions.option(m_longOptions.find(prefix));
+    }
+
+    // Names of the options an ambiguous long option prefix matches, empty when the argument is not ambiguous
+    BazPO_INLINE std::string Cli::abbreviationCandidates(const char* argument)
+    {
+        std::string candidates;
+        if (!m_abbreviations || argument[0] != '-' || argument[1] != '-' || argument[2] == '\0')
+            return candidates;
+        const char* equals = std::strchr(argument, '=');
+        indexLongOptions();
+        auto range = m_longOptions.find(_detail::StringRef(argument, equals != nullptr ? static_cast<size_t>(equals - argument) : std::strlen(argument), false));
+        if (range.second - range.first < 2 || m_longOptions.option(range) != nullptr)
+            return candidates;
+        for (size_t i = range.first; i < range.second; ++i)
+            candidates.append(i == range.first ? "" : " ").append(m_longOptions.names()[i].name.c_str());
+        return candidates;
+    }
+
+    // Splits --option=value, -ovalue and combined flags -xvf into their options and inline values, values point into the argument.
+    // The inline value is null when the value is not part of the argument, nothing is split when a part is not an option.
+    // Abbreviated long options are resolved here, callers match the whole argument first.
+    BazPO_INLINE bool Cli::splitArgument(const char* argument, std::vector<std::pair<Option*, const char*>>& options)
+    {
+        options.clear();
+        if (argument[0] != '-' || argument[1] == '\0')
+            return false;
+        if (argument[1] == '-')
+        {
+            const char* equals = std::strchr(argument, '=');
+            if (equals == nullptr && !m_abbreviations)
+                return false;
+            _detail::StringRef name(argument, equals != nullptr ? static_cast<size_t>(equals - argument) : std::strlen(argument), false);
+            Option* option = nullptr;
+            auto exact = equals != nullptr ? m_refMap.find(getKey(name)) : m_refMap.end();
+            if (exact != m_refMap.end())
+                option = &exact->second;
+            else
+                option = abbreviatedOption(name);
+            if (option == nullptr || (equals != nullptr && option->MaxValueCount == 0))
+                return false;
+            options.emplace_back(option, equals != nullptr ? equals + 1 : nullptr);
+            return true;
+        }
+
+        indexShortOptions();
+        for (const char* c = argument + 1; *c != '\0'; ++c)
+        {
+            Option* option = m_shortOptions[static_cast<unsigned char>(*c)];
+            if (option == nullptr)
+            {
+                options.clear();
+                return false;
+            }
+            // Rest of the argument is the value of an option taking values
+            if (option->MaxValueCount > 0)
+            {
+                options.emplace_back(option, *(c + 1) != '\0' ? c + 1 : nullptr);
+                return true;
+            }
+            options.emplace_back(option, nullptr);
+        }
+        return true;
+    }
+
+    BazPO_INLINE void Cli::parsePriority()
+    {
+        BazPO_TIME_PHASE(ParsePriority);
+        if (m_priorityMap.empty())
+            return;
+        Option* lastOption = nullptr;
+        std::vector<std::pair<Option*, const char*>> split;
+        for (int i = 1; i < m_argEnd; ++i)
+        {
+            m_argIndex = i;
+            auto key = getKey(m_argv[i]);
+            auto option = m_priorityMap.find(key);
+            if (option != m_priorityMap.end())
+            {
+                m_parsedPriority = true;
+                option->second.Exists = true;
+                ++option->second.ExistsCount;
+
+                if (option->second.maxValueCount() == 0)
+                    break;
+                lastOption = &option->second;
+            }
+            else if (m_refMap.find(key) == m_refMap.end() && splitArgument(m_argv[i], split))
+            {
+                bool prioritized = false;
+                bool takesValues = lastOption != nullptr;
+                lastOption = nullptr;
+                for (const auto& part : split)
+                {
+                    if (!part.first->Prioritized)
+                        continue;
+                    prioritized = m_parsedPriority = true;
+                    part.first->Exists = true;
+                    ++part.first->ExistsCount;
+                    if (part.first->maxValueCount() == 0)
+                        return;
+                    if (part.second != nullptr)
+                        addValue(*part.first, part.second);
+                    else
+                        lastOption = part.first;
+                }
+                // Another option ends the values of the prioritized option
+                if (!prioritized && takesValues)
+                    break;
+            }
+            else if (lastOption != nullptr)
+            {
+                if (m_refMap.find(key) == m_refMap.end())
+                {
+                    if (lastOption->maxValueCount() > lastOption->values().size() || lastOption->ParseType == _detail::OptionParseType::Value)
+                        addValue(*lastOption, m_argv[i]);
+                    else
+                        break;
+                    if (lastOption->ParseType == _detail::OptionParseType::Value)
+                        lastOption = nullptr;
+                }
+                else
+                    break;
+            }
+        }
+    }
+
+    BazPO_INLINE void Cli::parseOptions()
+    {
+        BazPO_TIME_PHASE(ParseOptions);
+        Option* lastOption = nullptr;
+        int taglessId = 0;
+        std::vector<std::pair<Option*, const char*>> split;
+        std::string candidates;
+        for (int i = 1; i < m_argEnd; ++i)
+        {
+            m_argIndex = i;
+            auto key = getKey(m_argv[i]);
+            auto option = m_refMap.find(key);
+            if (option != m_refMap.end())
+            {
+                option->second.Exists = true;
+                ++option->second.ExistsCount;
+                if(option->second.MaxValueCount > 0)
+                    lastOption = &option->second;
+            }
+            else if (splitArgument(m_argv[i], split))
+            {
+                lastOption = nullptr;
+                for (const auto& part : split)
+                {
+                    part.first->Exists = true;
+                    ++part.first->ExistsCount;
+                    if (part.second != nullptr)
+                    {
+                        addValue(*part.first, part.second);
+                        // Following arguments may provide more values
+                        if (part.first->ParseType == _detail::OptionParseType::MultiValue && part.first->MaxValueCount > part.first->Values.size())
+                            lastOption = part.first;
+                    }
+                    else if (part.first->MaxValueCount > 0)
+                        lastOption = part.first;
+                }
+            }
+            else if (!(candidates = abbreviationCandidates(m_argv[i])).empty())
+            {
+                lastOption = nullptr;
+                if (!report(Diagnostic::Kind::AmbiguousOption, nullptr, m_argv[i], nullptr, nullptr, candidates))
+                    ambiguousOptionError(m_argv[i], candidates);
+            }
+            else if (lastOption != nullptr)
+            {
+                if (lastOption->MaxValueCount > lastOption->Values.size() || lastOption->ParseType == _detail::OptionParseType::Value)
+                    addValue(*lastOption, m_argv[i]);
+                if (lastOption->ParseType == _detail::OptionParseType::Value || lastOption->MaxValueCount == lastOption->Values.size())
+                    lastOption = nullptr;
+            }
+            else if ((option = m_refMap.find(std::to_string(taglessId))) != m_refMap.end() && option->second.ParseType == _detail::OptionParseType::Unidentified)
+            {
+                option->second.Exists = true;
+                ++option->second.ExistsCount;
+                addValue(option->second, m_argv[i]);
+                if (option->second.ExistsCount == option->second.MaxValueCount)
+                    ++taglessId;
+            }
+            else if (m_exitOnUnexpectedValue && (taglessId > getCurrentId() || (lastOption!= nullptr && (lastOption->MaxValueCount < lastOption->Values.size()))))
+            {
+                if (!report(Diagnostic::Kind::UnexpectedArgument, nullptr, m_argv[i]))
+                    unknownArgParsingError(m_argv[i]);
+            }
+        }
+        m_argIndex = -1;
+    }
+
+    BazPO_INLINE void Cli::applySources()
+    {
+        BazPO_TIME_PHASE(ApplySources);
+        std::string name;
+        for (size_t rank = m_sources.size(); rank > 0; --rank)
+        {
+            for (const auto& sourceEntry : m_sources[rank - 1]->entries())
+            {
+                OptionSource::Entry entry = sourceEntry;
+                if (!sourceSection(sourceEntry.section, entry.section))
+                    continue;
+                auto option = findSourceOption(entry, name);
+                if (option == nullptr)
+                {
+                    if (m_exitOnUnexpectedValue && !report(Diagnostic::Kind::UnexpectedArgument, nullptr, intern(entry.key).c_str()))
+                        unknownArgParsingError(name);
+                    continue;
+                }
+                // Arguments and sources with higher precedence already provided this option
+                if ((option->Exists && option->SourceRank == 0) || (option->SourceRank != 0 && option->SourceRank != rank))
+                    continue;
+
+                option->SourceRank = rank;
+                // Only the values of the options are copied out of the source
+                const char* value = intern(entry.value).c_str();
+                if (option->MaxValueCount == 0)
+                {
+                    option->Exists = *value == '\0' || _detail::valueAs<bool>(value).first;
+                    option->ExistsCount = option->Exists ? 1 : 0;
+                    continue;
+                }
+                option->Exists = true;
+                ++option->ExistsCount;
+                if (option->ParseType == _detail::OptionParseType::MultiValue && option->Values.size() >= option->MaxValueCount && !report(Diagnostic::Kind::UnexpectedArgument, nullptr, value))
+                    unknownArgParsingError(value);
+                addValue(*option, value);
+            }
+        }
+    }
+
+    // Section relative to the section of this Cli, false for the sections of other Clis and of the subcommands
+    BazPO_INLINE bool Cli::sourceSection(_detail::StringRef section, _detail::StringRef& relative) const
+    {
+        const char* first = section.c_str();
+        const char* last = first + section.size();
+        if (!m_sourceSection.empty())
+        {
+            if (section.size() < m_sourceSection.size() || std::memcmp(first, m_sourceSection.c_str(), m_sourceSection.size()) != 0)
+                return false;
+            first += m_sourceSection.size();
+            if (first != last && *first++ != '.')
+                return false;
+        }
+        relative = _detail::StringRef(first, static_cast<size_t>(last - first), false);
+        if (m_subcommands.empty() || first == last)
+            return true;
+        const char* dot = static_cast<const char*>(std::memchr(first, '.', static_cast<size_t>(last - first)));
+        return m_subcommands.find(std::string(first, dot != nullptr ? dot : last)) == m_subcommands.end();
+    }
+
+    BazPO_INLINE Option* Cli::findSourceOption(const OptionSource::Entry& entry, std::string& name) const
+    {
+        name.assign(entry.section.c_str(), entry.section.size());
+        if (!name.empty())
+            name.append(".");
+        name.append(entry.key.c_str(), entry.key.size());
+        for (const char* prefix : { "", "--", "-" })
+        {
+            auto option = m_refMap.find(getKey(prefix + name));
+            if (option != m_refMap.end() && option->second.ParseType != _detail::OptionParseType::Unidentified)
+                return &option->second;
+        }
+        return nullptr;
+    }
+
+    BazPO_INLINE void Cli::checkMandatoryOptions()
+    {
+        BazPO_TIME_PHASE(CheckMandatoryOptions);
+        for (auto& pair : m_refMap)
+        {
+            if (!pair.second.MultiConstrained.empty() && std::all_of(pair.second.MultiConstrained.begin(), pair.second.MultiConstrained.end(), [&](MultiConstraint* constraint) { return constraint->satisfied(pair.second); }))
+                continue;
+            if (pair.second.Mandatory && !pair.second.Exists)
+            {
+                if (m_result != nullptr && !m_askInputForMandatoryOptions)
+                {
+                    if (m_exitOnUnexpectedValue && pair.second.MultiConstrained.empty())
+                        report(Diagnostic::Kind::MissingMandatory, &pair.second, nullptr);
+                    continue;
+                }
+                printOption(pair.second);
+                printOptionUsage(pair.second);
+                m_output << " is a required parameter\n";
+                if (m_askInputForMandatoryOptions)
+                    askInput(pair.second);
+                else if (m_exitOnUnexpectedValue && pair.second.MultiConstrained.empty())
+                    exitWithCode(1);
+            }
+        }
+    }
+
+    BazPO_INLINE void Cli::crossCheckMultiConstraints()
+    {
+        BazPO_TIME_PHASE(CrossCheckMultiConstraints);
+        for (auto& it : m_refMap)
+            for (auto& constraint : it.second.MultiConstrained)
+                if (!constraint->satisfied(it.second) && !report(Diagnostic::Kind::MultiConstraintViolation, &it.second, nullptr, nullptr, constraint))
+                    multiConstraintError(constraint->what());
+    }
+
+    BazPO_INLINE void Cli::addValue(Option& option, const char* value)
+    {
+        option.setValue(value);
+        if (!option.convert(value))
+            conversionError(option, value);
+    }
+
+    BazPO_INLINE void Cli::validateOptions()
+    {
+        BazPO_TIME_PHASE(ValidateOptions);
+        std::vector<Option*> options;
+        for (auto& pair : m_refMap)
+            if (!pair.second.Values.empty())
+                options.push_back(&pair.second);
+        validate(options);
+    }
+
+    // Dependencies may name options registered later, they are resolved once every option is registered
+    BazPO_INLINE void Cli::checkDependencies() const
+    {
+        for (const auto& pair : m_refMap)
+            for (const auto& dependency : pair.second.Dependencies)
+                if (m_refMap.find(getKey(dependency)) == m_refMap.end())
+                    BazPO_THROW(_detail::UnknownDependency(dependency));
+    }
+
+    // Each constraint is evaluated once over all values of an option, large value sets are split into jobs run by the callback executor.
+    // Constraints not checking each value see every value as the value of the option, one after the other on this thread.
+    // Without tryParse the violation of the earliest argument is reported.
+    BazPO_INLINE void Cli::validate(const std::vector<Option*>& options)
+    {
+        const size_t chunkSize = 4096;
+        struct Job
+        {
+            Option* option;
+            const Constraint* constraint;
+            size_t begin;
+            size_t end;
+            std::vector<size_t> violations;
+        };
+        std::vector<Job> jobs;
+        std::vector<size_t> concurrent;
+        for (auto option : options)
+        {
+            for (const auto& constraint : option->Constrained)
+            {
+                if (!constraint->checksEachValue())
+                {
+                    jobs.push_back({ option, constraint, 0, option->Values.size(), {} });
+                    continue;
+                }
+                for (size_t begin = 0; begin < option->Values.size(); begin += chunkSize)
+                {
+                    concurrent.push_back(jobs.size());
+                    jobs.push_back({ option, constraint, begin, std::min(begin + chunkSize, option->Values.size()), {} });
+                }
+            }
+        }
+        const bool all = m_result != nullptr;
+#ifdef BazPO_ENABLE_PARSE_TIMING
+        ParseObserver* observer = m_parseObserver;
+        auto check = [&jobs, &concurrent, all, observer](size_t index) {
+#else
+        auto check = [&jobs, &concurrent, all](size_t index) {
+#endif
+            auto& job = jobs[concurrent[index]];
+            BazPO_TIME_CONSTRAINT(observer, *job.option, job.end - job.begin);
+            for (size_t i = job.begin; i < job.end && (all || job.violations.empty()); ++i)
+                if (!job.constraint->accepts(job.option->Values[i]))
+                    job.violations.push_back(i);
+        };
+        if (m_callbackExecutor && concurrent.size() > 1)
+            m_callbackExecutor->forEach(concurrent.size(), check);
+        else
+            SequentialExecutor().forEach(concurrent.size(), check);
+        for (auto& job : jobs)
+        {
+            if (job.constraint->checksEachValue())
+                continue;
+            BazPO_TIME_CONSTRAINT(m_parseObserver, *job.option, job.end - job.begin);
+            const char* value = job.option->Value;
+            for (size_t i = job.begin; i < job.end && (all || job.violations.empty()); ++i)
+            {
+                job.option->Value = job.option->Values[i];
+                if (!job.constraint->satisfied())
+                    job.violations.push_back(i);
+            }
+            job.option->Value = value;
+        }
+
+        const Job* first = nullptr;
+        unsigned firstIndex = 0;
+        for (const auto& job : jobs)
+        {
+            for (auto violation : job.violations)
+            {
+                const char* value = job.option->Values[violation];
+                m_argIndex = argumentIndex(value);
+                const bool reported = job.constraint->converts(value) ? report(Diagnostic::Kind::ConstraintViolation, job.option, value, job.constraint) : report(Diagnostic::Kind::InvalidValue, job.option, value);
+                if (reported)
+                    continue;
+                if (first == nullptr || static_cast<unsigned>(m_argIndex) < firstIndex)
+                {
+                    first = &job;
+                    firstIndex = static_cast<unsigned>(m_argIndex);
+                }
+            }
+        }
+        m_argIndex = -1;
+        if (first != nullptr)
+        {
+            const char* value = first->option->Values[first->violations.front()];
+            if (!first->constraint->converts(value))
+                conversionError(*first->option, value);
+            else
+                constraintError(first->constraint->what(), value, first->option->Parameter);
+        }
+        for (auto option : options)
+        {
+            m_argIndex = argumentIndex(option->value());
+            for (const auto& multiConstraint : option->MultiConstrained)
+                if (!multiConstraint->satisfied(*option) && !report(Diagnostic::Kind::MultiConstraintViolation, option, option->value(), nullptr, multiConstraint))
+                    multiConstraintError(multiConstraint->what());
+        }
+        m_argIndex = -1;
+    }
+
+    // Index of the argument the value refers to, -1 for values from sources and input
+    BazPO_INLINE int Cli::argumentIndex(const char* value) const
+    {
+        std::less<const char*> before;
+        for (int i = 1; i < m_argEnd; ++i)
+            if (!before(value, m_argv[i]) && before(value, m_argv[i] + std::strlen(m_argv[i]) + 1))
+                return i;
+        return -1;
+    }
+
+    BazPO_INLINE void Cli::executeExistingOptions() const
+    {
+        BazPO_TIME_PHASE(ExecuteExistingOptions);
+        executeOptions(m_refMap);
+    }
+
+    BazPO_INLINE void Cli::executePriorityOptions() const
+    {
+        BazPO_TIME_PHASE(ExecutePriorityOptions);
+        executeOptions(m_priorityMap);
+    }
+
+    BazPO_INLINE void Cli::executeOptions(const std::map<_detail::StringRef, Option&>& options) const
+    {
+        std::vector<CallbackExecutor::Task> tasks;
+        std::map<const Option*, size_t> indices;
+        for (const auto& it : options)
+        {
+            if (!it.second.Exists)
+                continue;
+            indices.emplace(&it.second, tasks.size());
+            tasks.push_back({ &it.second, {} });
+#ifdef BazPO_ENABLE_PARSE_TIMING
+            tasks.back().observer = m_parseObserver;
+#endif
+        }
+        for (auto& task : tasks)
+        {
+            for (const auto& dependency : task.option->Dependencies)
+            {
+                auto index = indices.find(&m_refMap.find(getKey(dependency))->second);
+                if (index != indices.end())
+                    task.dependencies.push_back(index->second);
+            }
+        }
+        if (m_callbackExecutor)
+            m_callbackExecutor->execute(tasks);
+        else
+            SequentialExecutor().execute(tasks);
+    }
+
+    BazPO_INLINE void Cli::askInput(Option& option)
+    {
+        printOptionUsage(option);
+        m_output << ": ";
+        m_output.flush();
+        std::string temp;
+        m_input.readLine(temp);
+
+        if (!temp.empty())
+        {
+            m_inputStorage.emplace_back(temp);
+            addValue(option, m_inputStorage.back().c_str());
+            option.Exists = true;
+            ++option.ExistsCount;
+            validate({ &option });
+        }
+        else if (option.Mandatory && m_exitOnUnexpectedValue && option.MultiConstrained.empty() && !report(Diagnostic::Kind::MissingMandatory, &option, nullptr))
+            exitWithCode(1);
+    }
+
+    BazPO_INLINE std::string Cli::programName() const
+    {
+        std::string prgName(m_argv[0]);
+        size_t prgNameStart = prgName.find_last_of("\\");
+        if (prgNameStart == std::string::npos)
+            prgNameStart = prgName.find_last_of("/");
+
+        if (prgNameStart != std::string::npos)
+            prgName = prgName.substr(prgNameStart + 1);
+        return prgName;
+    }
+
+    BazPO_INLINE void Cli::printOptions()
+    {
+        measureOptions();
+        auto prgName = programName();
+        // Program Description
+        m_output << "\n";
+        m_output.padded(prgName, m_maxSecondOptionParameterSize + prgName.size()) << m_programDescription << "\n";
+        // Program Usage
+        m_output << "usage: " << prgName << " ";
+        for (const auto& pair : m_refMap)
+        {
+            m_output << " ";
+            printOptionUsage(pair.second);
+        }
+        if (!m_subcommands.empty())
+            m_output << " <subcommand> ...";
+        m_output << "\n";
+        // Options
+        m_output << "Program Options: \n";
+        for (const auto& pair : m_refMap)
+            printOption(pair.second);
+        if (!m_subcommands.empty())
+        {
+            m_output << "Subcommands: \n";
+            for (const auto& pair : m_subcommands)
+                m_output.padded(pair.first, m_maxOptionParameterSize + 9 + m_maxSecondOptionParameterSize + 10) << pair.second.description << "\n";
+        }
+        m_output.flush();
+    }
+
+    // Largest parameter sizes to use for padding, descriptions are not needed to measure
+    BazPO_INLINE void Cli::measureOptions()
+    {
+        if (m_optionsMeasured)
+            return;
+        m_optionsMeasured = true;
+        m_maxOptionParameterSize = 0;
+        m_maxSecondOptionParameterSize = 0;
+        for (const auto& pair : m_refMap)
+        {
+            m_maxOptionParameterSize = std::max(m_maxOptionParameterSize, pair.second.Parameter.size());
+            m_maxSecondOptionParameterSize = std::max(m_maxSecondOptionParameterSize, pair.second.SecondParameter.size());
+        }
+        for (const auto& pair : m_subcommands)
+            m_maxSecondOptionParameterSize = std::max(m_maxSecondOptionParameterSize, pair.first.size());
+    }
+
+    // The option gets the next handle unless the key is registered already
+    BazPO_INLINE void Cli::registerOption(_detail::StringRef key, Option& option)
+    {
+        auto registered = m_refMap.emplace(key, option);
+        registered.first->second.setCli(*this);
+        m_optionsMeasured = false;
+        if (!registered.second)
+            return;
+        option.Handle.index = static_cast<std::uint32_t>(m_options.size());
+        m_options.push_back(&option);
+    }
+
+    BazPO_INLINE void Cli::registerAlias(_detail::StringRef option, _detail::StringRef secondOption)
+    {
+        if (!secondOption.empty())
+            m_aliasMap.emplace(secondOption, option);
+    }
+
+    BazPO_INLINE void Cli::constraintError(const std::string& constraints, const std::string& value, const std::string& parameter)
+    {
+        m_output << "Expected " << constraints << " where -> '" << value << "' is not expected for option " << parameter;
+        exitWithCode(1);
+    }
+
+    BazPO_INLINE void Cli::multiConstraintError(const std::string& message)
+    {
+        m_output << message << "\n";
+        exitWithCode(1);
+    }
+
+    BazPO_INLINE void Cli::conversionError(const Option& option, const char* value)
+    {
+        if (m_result != nullptr)
+        {
+            std::lock_guard<std::mutex> lock(m_reportMutex);
+            // Values converted by option functions after parsing refer to their argument
+            const int argIndex = m_argIndex;
+            if (argIndex < 0)
+                m_argIndex = argumentIndex(value);
+            report(Diagnostic::Kind::InvalidValue, &option, value);
+            m_argIndex = argIndex;
+            return;
+        }
+        m_output << "Type of value '" << value << "' is not expected for option " << option.Parameter;
+        exitWithCode(1);
+    }
+
+    BazPO_INLINE void Cli::unknownArgParsingError(const std::string& value)
+    {
+        m_output << "Given value -> '" << value << "' is not expected";
+        exitWithCode(1);
+    }
+
+    BazPO_INLINE void Cli::ambiguousOptionError(const std::string& value, const std::string& candidates)
+    {
+        m_output << "Option '" << value << "' is ambiguous, possible options: " << candidates << "\n";
+        exitWithCode(1);
+    }
+
+    BazPO_INLINE void Cli::printOptionUsage(const Option& option)
+    {
+        if (option.ParseType == _detail::OptionParseType::Unidentified)
+            if (option.Mandatory)
+                m_output << option.description() << sizeSyntax(option.maxValueCount()) << " ";
+            else
+                m_output << "[" << option.description() << sizeSyntax(option.maxValueCount()) << "] ";
+        else
+            m_output << parameterSyntax(option.Parameter, option.Mandatory);
+    }
+
+    BazPO_INLINE void Cli::printOption(const Option& option)
+    {
+        measureOptions();
+        if (option.ParseType != _detail::OptionParseType::Unidentified)
+        {
+            m_output.padded(parameterSyntax(option.Parameter, option.Mandatory), m_maxOptionParameterSize + 9);
+            m_output.padded(option.SecondParameter, m_maxSecondOptionParameterSize + 10) << option.description() << "\n";
+        }
+        else
+            m_output.padded(parameterSyntax(option.description(), option.Mandatory), m_maxOptionParameterSize + 9 + m_maxSecondOptionParameterSize + 10) << sizeSyntax(option.maxValueCount()) << "\n";
+    }
+
+    BazPO_INLINE std::string Cli::sizeSyntax(size_t value) const
+    {
+        std::string str;
+        if (value == 1)
+            str.append("(").append(std::to_string(value)).append(")");
+        else if (value == SIZE_MAX)
+            str.append("(").append("*...)");
+        else if (value > 1)
+            str.append("(").append(std::to_string(value)).append("...)");
+        return str;
+    }
+
+    BazPO_INLINE std::string Cli::parameterSyntax(const std::string& value, bool mandatory) const
+    {
+        std::string str;
+        if (mandatory)
+            str.append("<").append(value).append(">");
+        else if (value == "")
+            return str;
+        else
+            str.append("[").append(value).append("]");
+        return str;
+    }
+}
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef BAZ_PO_ENUM_OPTION_HPP
+#define BAZ_PO_ENUM_OPTION_HPP
+
+/*
+BazPO enum option.
+Copyright (c) 2022 Baris Tanyeri
+https://github.com/karusb/BazPO
+MIT License
+*/
+
+#include "../BazPO.hpp"
+#include <cstdint>
+
+namespace BazPO
+{
+    template <typename E>
+    struct EnumName
+    {
+        const char* name;
+        E value;
+    };
+
+    namespace _detail
+    {
+        class InvalidEnumTable
+            : public std::exception
+        {
+            const char* err = "Enum names have to be unique and not empty!";
+            const char* what() const noexcept override { return err; };
+        };
+        // Not constexpr, reaching it while building a table at compile time fails the compilation
+        inline void invalidEnumTable() { BazPO_THROW(InvalidEnumTable()); }
+
+        // FNV-1a
+        constexpr std::uint64_t hashName(const char* name)
+        {
+            std::uint64_t hash = 14695981039346656037ull;
+            for (; *name != '\0'; ++name)
+                hash = (hash ^ static_cast<unsigned char>(*name)) * 1099511628211ull;
+            return hash;
+        }
+        // Second level hash of the bucket, mixes the name hash with the displacement of its bucket
+        constexpr std::uint64_t displaceHash(std::uint64_t hash, std::uint32_t displacement)
+        {
+            hash += displacement * 0x9E3779B97F4A7C15ull;
+            hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+            hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+            return hash ^ (hash >> 31);
+        }
+        constexpr bool sameName(const char* first, const char* second)
+        {
+            for (; *first != '\0' && *first == *second; ++first, ++second) {}
+            return *first == *second;
+        }
+        constexpr size_t enumSlotCount(size_t names)
+        {
+            size_t count = 1;
+            while (count < 2 * names)
+                count <<= 1;
+            return count;
+        }
+    }
+
+    // Names of an enum with a perfect hash built at compile time: names are hashed into buckets, every bucket gets
+    // the displacement placing its names into free slots. Looking a name up hashes it once and compares it once.
+    template <typename E, size_t N>
+    class EnumTable
+    {
+        static_assert(N > 0 && N < UINT16_MAX, "Enum tables have between 1 and 65534 names");
+    public:
+        static constexpr size_t SlotCount = _detail::enumSlotCount(N);
+        static constexpr size_t BucketCount = SlotCount / 2;
+
+        constexpr EnumTable(const EnumName<E> (&entries)[N])
+            : names{}
+            , slots{}
+            , displacements{}
+        {
+            std::uint64_t hashes[N] = {};
+            size_t bucketSizes[BucketCount] = {};
+            size_t largestBucket = 0;
+            for (size_t i = 0; i < N; ++i)
+            {
+                if (entries[i].name == nullptr || entries[i].name[0] == '\0')
+                    _detail::invalidEnumTable();
+                for (size_t j = 0; j < i; ++j)
+                    if (_detail::sameName(entries[i].name, entries[j].name))
+                        _detail::invalidEnumTable();
+                names[i] = entries[i];
+                hashes[i] = _detail::hashName(entries[i].name);
+                auto& bucketSize = bucketSizes[hashes[i] & (BucketCount - 1)];
+                if (++bucketSize > largestBucket)
+                    largestBucket = bucketSize;
+            }
+            // Larger buckets are placed first while most slots are free
+            for (size_t size = largestBucket; size > 0; --size)
+                for (size_t bucket = 0; bucket < BucketCount; ++bucket)
+                    if (bucketSizes[bucket] == size)
+                        place(bucket, hashes);
+        }
+
+        // Entry of the name, nullptr when the name is not in the table
+        constexpr const EnumName<E>* find(const char* name) const
+        {
+            auto hash = _detail::hashName(name);
+            auto slot = slots[_detail::displaceHash(hash, displacements[hash & (BucketCount - 1)]) & (SlotCount - 1)];
+            if (slot == 0 || !_detail::sameName(names[slot - 1].name, name))
+                return nullptr;
+            return &names[slot - 1];
+        }
+        // First name of the value, empty when the value has no name
+        constexpr const char* name(E value) const
+        {
+            for (const auto& entry : names)
+                if (entry.value == value)
+                    return entry.name;
+            return "";
+        }
+        static constexpr size_t size() { return N; }
+        constexpr const EnumName<E>* begin() const { return names; }
+        constexpr const EnumName<E>* end() const { return names + N; }
+
+    private:
+        constexpr void place(size_t bucket, const std::uint64_t (&hashes)[N])
+        {
+            for (std::uint32_t displacement = 0; displacement < (1u << 20); ++displacement)
+            {
+                bool placed = true;
+                for (size_t i = 0; i < N && placed; ++i)
+                {
+                    if ((hashes[i] & (BucketCount - 1)) != bucket)
+                        continue;
+                    auto& slot = slots[_detail::displaceHash(hashes[i], displacement) & (SlotCount - 1)];
+                    if (slot != 0)
+                        placed = false;
+                    else
+                        slot = static_cast<std::uint16_t>(i + 1);
+                }
+                if (placed)
+                {
+                    displacements[bucket] = displacement;
+                    return;
+                }
+                for (size_t i = 0; i < N; ++i)
+                {
+                    if ((hashes[i] & (BucketCount - 1)) != bucket)
+                        continue;
+                    auto& slot = slots[_detail::displaceHash(hashes[i], displacement) & (SlotCount - 1)];
+                    if (slot == i + 1)
+                        slot = 0;
+                }
+            }
+            _detail::invalidEnumTable();
+        }
+
+        EnumName<E> names[N];
+        // Index of the name plus one, zero for free slots
+        std::uint16_t slots[SlotCount];
+        std::uint32_t displacements[BucketCount];
+    };
+
+    // constexpr auto colors = BazPO::enumTable<Color>({ { "red", Color::Red }, { "green", Color::Green } });
+    template <typename E, size_t N>
+    constexpr EnumTable<E, N> enumTable(const EnumName<E> (&entries)[N])
+    {
+        return EnumTable<E, N>(entries);
+    }
+
+    // Value is one of the names of the table, the enum value is stored while parsing and other names are reported as invalid values.
+    // Allowed names are listed in the description and in shell completion.
+    template <typename E, size_t N>
+    class EnumOption
+        : public ValueOption
+    {
+    public:
+        EnumOption(ICli* po, const EnumTable<E, N>& table, _detail::StringRef parameter, _detail::StringRef secondParameter = "", _detail::StringRef description = "", E defaultValue = E(), bool mandatory = false)
+            : ValueOption(po, parameter, secondParameter, describe(description, table), table.name(defaultValue), mandatory)
+            , table(table)
+            , enumValue(defaultValue)
+        {}
+
+        inline E get() const { return enumValue; }
+
+    protected:
+        virtual bool convert(const char* value) override
+        {
+            auto entry = table.find(value);
+            if (entry == nullptr)
+                return false;
+            enumValue = entry->value;
+            return true;
+        }
+        virtual void complete(const char* prefix, std::string& candidates) const override
+        {
+            const size_t prefixSize = std::strlen(prefix);
+            for (const auto& entry : table)
+                if (std::strncmp(entry.name, prefix, prefixSize) == 0)
+                    candidates.append(entry.name).append("\n");
+            ValueOption::complete(prefix, candidates);
+        }
+
+    private:
+        static std::string describe(_detail::StringRef description, const EnumTable<E, N>& table)
+        {
+            std::string described = description.str();
+            if (!described.empty())
+                described.append(" ");
+            for (size_t i = 0; i < N; ++i)
+                described.append(i == 0 ? "{" : ",").append(table.begin()[i].name);
+            return described.append("}");
+        }
+
+        EnumTable<E, N> table;
+        E enumValue;
+    };
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef BAZ_PO_FILE_OPTION_HPP
+#define BAZ_PO_FILE_OPTION_HPP
+
+/*
+BazPO file option.
+Copyright (c) 2022 Baris Tanyeri
+https://github.com/karusb/BazPO
+MIT License
+*/
+
+#include "../BazPO.hpp"
+#include <atomic>
+#include <mutex>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace BazPO
+{
+    // Value is the path of an existing regular file. The file is opened and read ahead asynchronously
+    // as soon as the argument is parsed, contents are mapped read only on first access.
+    class FileOption
+        : public ValueOption
+    {
+    public:
+        FileOption(ICli* po, _detail::StringRef parameter, _detail::StringRef secondParameter = "", _detail::StringRef description = "", _detail::StringRef defaultValue = "", bool mandatory = false)
+            : ValueOption(po, parameter, secondParameter, description, defaultValue, mandatory)
+        {
+            if (!defaultValue.empty() && !open(value()))
+                BazPO_THROW(_detail::InvalidDefaultValue());
+        }
+        ~FileOption() override { close(); }
+
+        // Contents of the file, empty when the option is not given
+        inline const char* data() const
+        {
+            if (!mapped.load(std::memory_order_acquire))
+            {
+                std::lock_guard<std::mutex> lock(mappingMutex);
+                if (!mapped.load(std::memory_order_relaxed))
+                {
+                    map();
+                    mapped.store(true, std::memory_order_release);
+                }
+            }
+            return contents;
+        }
+        inline size_t size() const { return fileSize; }
+
+    protected:
+        virtual bool convert(const char* value) override
+        {
+            close();
+            return open(value);
+        }
+
+    private:
+        bool open(const char* path)
+        {
+#if defined(_WIN32)
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file)
+                return false;
+            fileSize = static_cast<size_t>(file.tellg());
+            return true;
+#else
+            fd = ::open(path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return false;
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+            {
+                close();
+                return false;
+            }
+            fileSize = static_cast<size_t>(st.st_size);
+#if defined(POSIX_FADV_WILLNEED)
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+            return true;
+#endif
+        }
+
+        void map() const
+        {
+            if (fileSize == 0)
+                return;
+#if defined(_WIN32)
+            std::ifstream file(value(), std::ios::binary);
+            buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            contents = buffer.data();
+#else
+            if (fd < 0)
+                return;
+            void* result = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (result == MAP_FAILED)
+                return;
+            mapping = result;
+            contents = static_cast<const char*>(mapping);
+#endif
+        }
+
+        void close()
+        {
+#if !defined(_WIN32)
+            if (mapping != nullptr)
+                ::munmap(mapping, fileSize);
+            mapping = nullptr;
+            if (fd >= 0)
+                ::close(fd);
+            fd = -1;
+#endif
+            contents = "";
+            fileSize = 0;
+            mapped.store(false, std::memory_order_release);
+        }
+
+        mutable std::mutex mappingMutex;
+        mutable std::atomic<bool> mapped{ false };
+        mutable const char* contents = "";
+        size_t fileSize = 0;
+#if defined(_WIN32)
+        mutable std::string buffer;
+#else
+        mutable void* mapping = nullptr;
+        int fd = -1;
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef BAZ_PO_MAP_OPTION_HPP
+#define BAZ_PO_MAP_OPTION_HPP
+
+/*
+BazPO map option.
+Copyright (c) 2022 Baris Tanyeri
+https://github.com/karusb/BazPO
+MIT License
+*/
+
+#include "../BazPO.hpp"
+
+namespace BazPO
+{
+    // Value kept when a key is given more than once
+    enum class MapPolicy
+    {
+        LastWins,
+        FirstWins
+    };
+
+    // Values are key=value definitions such as -D name=value, split while parsing into views of the arguments.
+    // Keys are found through an open addressing hash index, entries are iterated in the order their keys were first given.
+    // A definition without '=' has an empty value, an empty key is an invalid value.
+    class MapOption
+        : public MultiOption
+    {
+    public:
+        struct Entry
+        {
+            // Key is not null terminated, it is followed by '=' in the argument
+            const char* key;
+            size_t keySize;
+            const char* value;
+
+            inline std::string name() const { return std::string(key, keySize); }
+        };
+
+        MapOption(ICli* po, _detail::StringRef parameter, _detail::StringRef secondParameter = "", _detail::StringRef description = "", MapPolicy policy = MapPolicy::LastWins, bool mandatory = false)
+            : MultiOption(po, parameter, secondParameter, description, "", mandatory)
+            , policy(policy)
+        {}
+
+        // Value of the key, null when the key was not given
+        const char* find(_detail::StringRef key) const
+        {
+            auto slot = findSlot(key.c_str(), key.size());
+            return slot != nullptr && *slot != 0 ? entries[*slot - 1].value : nullptr;
+        }
+        inline bool contains(_detail::StringRef key) const { return find(key) != nullptr; }
+        // Converted value of the key, the fallback when the key was not given or can not be converted.
+        // valueAs<T>() of the option still converts the last definition as given.
+        template <typename T>
+        T valueAt(_detail::StringRef key, T fallback = T()) const
+        {
+            auto value = find(key);
+            if (value == nullptr)
+                return fallback;
+            auto valPair = _detail::valueAs<T>(value);
+            return valPair.second ? fallback : valPair.first;
+        }
+        inline size_t size() const { return entries.size(); }
+        inline std::vector<Entry>::const_iterator begin() const { return entries.begin(); }
+        inline std::vector<Entry>::const_iterator end() const { return entries.end(); }
+
+    protected:
+        virtual bool convert(const char* value) override
+        {
+            const char* equals = std::strchr(value, '=');
+            const size_t keySize = equals != nullptr ? static_cast<size_t>(equals - value) : std::strlen(value);
+            if (keySize == 0)
+                return false;
+            const char* definition = equals != nullptr ? equals + 1 : value + keySize;
+            if ((entries.size() + 1) * 2 > slots.size())
+                grow();
+            auto slot = findSlot(value, keySize);
+            if (*slot == 0)
+            {
+                entries.push_back({ value, keySize, definition });
+                *slot = static_cast<std::uint32_t>(entries.size());
+            }
+            else if (policy == MapPolicy::LastWins)
+                entries[*slot - 1].value = definition;
+            return true;
+        }
+
+    private:
+        static size_t hash(const char* key, size_t size)
+        {
+            size_t value = static_cast<size_t>(14695981039346656037ULL);
+            for (size_t i = 0; i < size; ++i)
+                value = (value ^ static_cast<unsigned char>(key[i])) * static_cast<size_t>(1099511628211ULL);
+            return value;
+        }
+        // Slot of the key or the empty slot it would be stored in, null when there are no slots
+        const std::uint32_t* findSlot(const char* key, size_t size) const
+        {
+            if (slots.empty())
+                return nullptr;
+            const size_t mask = slots.size() - 1;
+            for (size_t i = hash(key, size) & mask;; i = (i + 1) & mask)
+            {
+                if (slots[i] == 0)
+                    return &slots[i];
+                const auto& entry = entries[slots[i] - 1];
+                if (entry.keySize == size && std::memcmp(entry.key, key, size) == 0)
+                    return &slots[i];
+            }
+        }
+        std::uint32_t* findSlot(const char* key, size_t size) { return const_cast<std::uint32_t*>(static_cast<const MapOption&>(*this).findSlot(key, size)); }
+        void grow()
+        {
+            std::vector<std::uint32_t> grown(slots.empty() ? 16 : slots.size() * 2, 0);
+            const size_t mask = grown.size() - 1;
+            for (size_t index = 0; index < entries.size(); ++index)
+            {
+                size_t i = hash(entries[index].key, entries[index].keySize) & mask;
+                while (grown[i] != 0)
+                    i = (i + 1) & mask;
+                grown[i] = static_cast<std::uint32_t>(index + 1);
+            }
+            slots.swap(grown);
+        }
+
+        MapPolicy policy;
+        std::vector<Entry> entries;
+        // Index of the entry plus one, zero for empty slots
+        std::vector<std::uint32_t> slots;
+    };
+}
+
+#endif
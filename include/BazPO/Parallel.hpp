@@ -0,0 +1,223 @@
+#ifndef BAZ_PO_PARALLEL_HPP
+#define BAZ_PO_PARALLEL_HPP
+
+/*
+BazPO parallel option function execution.
+Copyright (c) 2022 Baris Tanyeri
+https://github.com/karusb/BazPO
+MIT License
+*/
+
+#include "../BazPO.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace BazPO
+{
+    // Executes independent option functions concurrently, a function starts once the functions it depends on finished.
+    // Functions depending on a failed function are skipped, the exception of the failed function with the lowest key is rethrown.
+    // The worker threads are started once and wait for work until the executor is destroyed, the calling thread works as well.
+    // A call made while another call is running, e.g. from an option function, runs on the calling thread only.
+    class ParallelExecutor
+        : public CallbackExecutor
+    {
+    public:
+        explicit ParallelExecutor(size_t threadCount = std::thread::hardware_concurrency())
+            : threadCount(threadCount > 0 ? threadCount : 1)
+        {
+            workers.reserve(this->threadCount - 1);
+            for (size_t i = 0; i + 1 < this->threadCount; ++i)
+                workers.emplace_back([this]() { wait(); });
+        }
+        ~ParallelExecutor() override
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto& worker : workers)
+                worker.join();
+        }
+
+        virtual void execute(const std::vector<Task>& tasks) override
+        {
+            // Rejects dependency cycles before anything is executed
+            order(tasks);
+            if (tasks.empty())
+                return;
+
+            Run run(tasks);
+            share([&run]() { run.work(); }, std::min(threadCount, tasks.size()) - 1);
+
+            for (const auto& error : run.errors)
+                if (error)
+                    std::rethrow_exception(error);
+        }
+
+        // Jobs are taken in index order by the threads, the exception of the job with the lowest index is rethrown
+        virtual void forEach(size_t count, const std::function<void(size_t)>& job) override
+        {
+            std::atomic<size_t> next{ 0 };
+            std::vector<std::exception_ptr> errors(count);
+            auto work = [&]() {
+                for (size_t index = next++; index < count; index = next++)
+                {
+                    try
+                    {
+                        job(index);
+                    }
+                    catch (...)
+                    {
+                        errors[index] = std::current_exception();
+                    }
+                }
+            };
+            share(work, std::min(threadCount, count) - (count > 0 ? 1 : 0));
+
+            for (const auto& error : errors)
+                if (error)
+                    std::rethrow_exception(error);
+        }
+
+    private:
+        // Runs the work on the calling thread and on the given number of workers, returns when all of them returned
+        void share(const std::function<void()>& work, size_t helperCount)
+        {
+            std::unique_lock<std::mutex> running(runningMutex, std::try_to_lock);
+            if (!running.owns_lock() || helperCount == 0)
+            {
+                work();
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                shared = &work;
+                helpersWanted = helperCount;
+                helpersActive = helperCount;
+                ++generation;
+            }
+            wake.notify_all();
+            work();
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this]() { return helpersActive == 0; });
+            shared = nullptr;
+        }
+        void wait()
+        {
+            size_t seen = 0;
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;)
+            {
+                wake.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+                if (helpersWanted == 0)
+                    continue;
+                --helpersWanted;
+                const auto& work = *shared;
+                lock.unlock();
+                work();
+                lock.lock();
+                if (--helpersActive == 0)
+                    done.notify_all();
+            }
+        }
+
+        struct Run
+        {
+            explicit Run(const std::vector<Task>& tasks)
+                : tasks(tasks)
+                , remaining(tasks.size())
+                , dependents(tasks.size())
+                , blocked(tasks.size(), false)
+                , errors(tasks.size())
+            {
+                for (size_t i = 0; i < tasks.size(); ++i)
+                {
+                    std::set<size_t> dependencies(tasks[i].dependencies.begin(), tasks[i].dependencies.end());
+                    remaining[i] = dependencies.size();
+                    for (auto dependency : dependencies)
+                        dependents[dependency].push_back(i);
+                    if (dependencies.empty())
+                        ready.insert(i);
+                }
+            }
+
+            void work()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                for (;;)
+                {
+                    changed.wait(lock, [this]() { return !ready.empty() || finished == tasks.size(); });
+                    if (finished == tasks.size())
+                        return;
+                    size_t index = *ready.begin();
+                    ready.erase(ready.begin());
+
+                    lock.unlock();
+                    std::exception_ptr error;
+                    try
+                    {
+                        CallbackExecutor::run(tasks[index]);
+                    }
+                    catch (...)
+                    {
+                        error = std::current_exception();
+                    }
+                    lock.lock();
+
+                    errors[index] = error;
+                    complete(index, error != nullptr);
+                    changed.notify_all();
+                }
+            }
+
+            void complete(size_t index, bool failed)
+            {
+                ++finished;
+                for (auto dependent : dependents[index])
+                {
+                    blocked[dependent] = blocked[dependent] || failed;
+                    if (--remaining[dependent] > 0)
+                        continue;
+                    if (blocked[dependent])
+                        complete(dependent, true);
+                    else
+                        ready.insert(dependent);
+                }
+            }
+
+            const std::vector<Task>& tasks;
+            std::vector<size_t> remaining;
+            std::vector<std::vector<size_t>> dependents;
+            std::vector<bool> blocked;
+            std::vector<std::exception_ptr> errors;
+            // Lowest index first, keeps the execution order close to the sequential order
+            std::set<size_t> ready;
+            size_t finished = 0;
+            std::mutex mutex;
+            std::condition_variable changed;
+        };
+
+        size_t threadCount;
+        std::vector<std::thread> workers;
+        // One call shares the workers at a time
+        std::mutex runningMutex;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void()>* shared = nullptr;
+        size_t helpersWanted = 0;
+        size_t helpersActive = 0;
+        size_t generation = 0;
+        bool stopping = false;
+    };
+}
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef BAZ_PO_RELOAD_HPP
+#define BAZ_PO_RELOAD_HPP
+
+/*
+BazPO configuration reload.
+Copyright (c) 2022 Baris Tanyeri
+https://github.com/karusb/BazPO
+MIT License
+*/
+
+#include "../BazPO.hpp"
+#include "Serialization.hpp"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace BazPO
+{
+    // Options parsed again from the arguments and sources on reload, e.g. after SIGHUP, published as immutable serialized snapshots.
+    // Readers never block, a reader keeps the snapshot it started with. A reload waits until the readers of the replaced snapshot are gone.
+    // Option functions are executed by the first parse only, reloads parse and validate without side effects unless enabled.
+    class ReloadableCli
+    {
+    public:
+        // Registers the options and sources on the Cli created for each parse
+        using Setup = std::function<void(Cli&)>;
+        // Called by the reloading thread with the keys of the changed options, the views live until the watcher returns
+        using Watcher = std::function<void(const std::vector<std::string>& changed, const CliView& previous, const CliView& current)>;
+
+        class Reader
+        {
+        public:
+            Reader(const Reader&) = delete;
+            Reader(Reader&& other) noexcept : readers(other.readers), view(other.view) { other.readers = nullptr; }
+            ~Reader()
+            {
+                if (readers != nullptr)
+                    readers->fetch_sub(1);
+            }
+
+            inline const CliView& operator*() const { return *view; }
+            inline const CliView* operator->() const { return view; }
+
+        private:
+            Reader(std::atomic<size_t>* readers, const CliView* view) : readers(readers), view(view) {}
+
+            std::atomic<size_t>* readers;
+            const CliView* view;
+
+            friend class ReloadableCli;
+        };
+
+        // Parses like Cli::parse, the program exits when the arguments are invalid
+        ReloadableCli(int argc, const char* argv[], const Setup& setup, const char* programDescription = "")
+            : argc(argc)
+            , argv(argv)
+            , programDescription(programDescription)
+            , setup(setup)
+        {
+            Cli cli{ argc, argv, programDescription };
+            setup(cli);
+            cli.parse();
+            current.store(new Snapshot(serialize(cli)));
+        }
+        ReloadableCli(const ReloadableCli&) = delete;
+        ~ReloadableCli() { delete current.load(); }
+
+        // Current snapshot, valid as long as the reader lives. A reader must not be kept by the thread reloading.
+        Reader read() const
+        {
+            auto& counter = readers[epoch.load() & 1].count;
+            counter.fetch_add(1);
+            return Reader(&counter, &current.load()->view);
+        }
+
+        inline void watch(const Watcher& watcher)
+        {
+            std::lock_guard<std::mutex> lock(reloading);
+            watchers.emplace_back(watcher);
+        }
+        // Reloads execute the option functions as well, once the reparsed options are valid and before the snapshot is published
+        inline void functionsExecutedOnReload()
+        {
+            std::lock_guard<std::mutex> lock(reloading);
+            executeFunctions = true;
+        }
+
+        // Parses the arguments and sources again, the snapshot is replaced only when there are no errors
+        ParseResult reload()
+        {
+            std::lock_guard<std::mutex> lock(reloading);
+            requested.store(false);
+            Cli cli{ argc, argv, programDescription };
+            setup(cli);
+            if (!executeFunctions)
+                cli.functionsDisabled();
+            auto result = cli.tryParse();
+            if (!result)
+                return result;
+
+            std::unique_ptr<Snapshot> previous(current.exchange(new Snapshot(serialize(cli))));
+            const CliView& published = current.load()->view;
+            auto changed = published.changedSince(previous->view);
+            if (!changed.empty())
+                for (const auto& watcher : watchers)
+                    watcher(changed, previous->view, published);
+            waitForReaders();
+            return result;
+        }
+
+        // Async signal safe, the reload happens on the next reloadIfRequested
+        inline void requestReload() { requested.store(true); }
+        inline ParseResult reloadIfRequested() { return requested.load() ? reload() : ParseResult(); }
+
+    private:
+        struct Snapshot
+        {
+            explicit Snapshot(const std::string& buffer)
+                : storage((buffer.size() + sizeof(std::uint32_t) - 1) / sizeof(std::uint32_t))
+                , view(copy(storage, buffer), buffer.size())
+            {}
+            static const void* copy(std::vector<std::uint32_t>& storage, const std::string& buffer)
+            {
+                std::memcpy(storage.data(), buffer.data(), buffer.size());
+                return storage.data();
+            }
+
+            std::vector<std::uint32_t> storage;
+            CliView view;
+        };
+        // Readers of an epoch, padded to keep the counters on separate cache lines
+        struct Readers
+        {
+            std::atomic<size_t> count{ 0 };
+            char padding[64 - sizeof(std::atomic<size_t>)];
+        };
+
+        // Readers register in the counter of the current epoch before loading the snapshot, a reader registering after
+        // the counter was seen empty loads the published snapshot. Switching the epoch lets the old counter drain.
+        void waitForReaders()
+        {
+            auto previousEpoch = epoch.load();
+            drain(readers[(previousEpoch + 1) & 1].count);
+            epoch.store(previousEpoch + 1);
+            drain(readers[previousEpoch & 1].count);
+        }
+        static void drain(const std::atomic<size_t>& counter)
+        {
+            while (counter.load() != 0)
+                std::this_thread::yield();
+        }
+
+        int argc;
+        const char** argv;
+        const char* programDescription;
+        Setup setup;
+        std::vector<Watcher> watchers;
+        bool executeFunctions = false;
+        std::mutex reloading;
+        std::atomic<bool> requested{ false };
+        std::atomic<Snapshot*> current{ nullptr };
+        std::atomic<size_t> epoch{ 0 };
+        mutable Readers readers[2];
+    };
+}
+
+#endif
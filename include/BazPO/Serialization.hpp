@@ -0,0 +1,500 @@
+#ifndef BAZ_PO_SERIALIZATION_HPP
+#define BAZ_PO_SERIALIZATION_HPP
+
+/*
+BazPO parse result serialization.
+Copyright (c) 2022 Baris Tanyeri
+https://github.com/karusb/BazPO
+MIT License
+*/
+
+#include "../BazPO.hpp"
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace BazPO
+{
+    namespace _detail
+    {
+        class SerializationError
+            : public std::exception
+        {
+        public:
+            explicit SerializationError(const char* message) : err(message) {}
+            const char* what() const noexcept override { return err; };
+        private:
+            const char* err;
+        };
+
+        // Every offset is relative to the beginning of the buffer, strings are null terminated
+        struct SerializedHeader
+        {
+            static constexpr std::uint32_t Magic = 0x4F505A42; // "BZPO"
+            static constexpr std::uint32_t Version = 2;
+
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::uint32_t size;
+            std::uint32_t optionCount;
+            std::uint32_t aliasCount;
+            std::uint32_t valueCount;
+            std::uint32_t handleCount;
+            std::uint32_t options;
+            std::uint32_t aliases;
+            std::uint32_t values;
+            std::uint32_t existence;
+            std::uint32_t handles;
+        };
+        // Sorted by key
+        struct SerializedOption
+        {
+            std::uint32_t key;
+            std::uint32_t value;
+            std::uint32_t firstValue;
+            std::uint32_t valueCount;
+            std::int32_t existsCount;
+        };
+        // Sorted by alias
+        struct SerializedAlias
+        {
+            std::uint32_t alias;
+            std::uint32_t option;
+        };
+
+        class Serializer
+        {
+        public:
+            static std::string serialize(const Cli& cli)
+            {
+                std::vector<std::pair<const char*, const Option*>> options;
+                for (const auto& pair : cli.m_refMap)
+                    options.emplace_back(pair.first.c_str(), &pair.second);
+                std::sort(options.begin(), options.end(), [](const auto& l, const auto& r) { return std::strcmp(l.first, r.first) < 0; });
+                std::vector<std::pair<const char*, std::uint32_t>> aliases;
+                for (const auto& pair : cli.m_aliasMap)
+                {
+                    auto option = std::lower_bound(options.begin(), options.end(), pair.second.c_str(), [](const auto& l, const char* r) { return std::strcmp(l.first, r) < 0; });
+                    if (option != options.end() && pair.second == option->first)
+                        aliases.emplace_back(pair.first.c_str(), static_cast<std::uint32_t>(option - options.begin()));
+                }
+                std::sort(aliases.begin(), aliases.end(), [](const auto& l, const auto& r) { return std::strcmp(l.first, r.first) < 0; });
+
+                size_t valueCount = 0;
+                for (const auto& option : options)
+                    valueCount += option.second->Values.size();
+
+                SerializedHeader header{};
+                header.magic = SerializedHeader::Magic;
+                header.version = SerializedHeader::Version;
+                header.optionCount = static_cast<std::uint32_t>(options.size());
+                header.aliasCount = static_cast<std::uint32_t>(aliases.size());
+                header.valueCount = static_cast<std::uint32_t>(valueCount);
+                header.options = sizeof(SerializedHeader);
+                header.aliases = header.options + header.optionCount * sizeof(SerializedOption);
+                header.values = header.aliases + header.aliasCount * sizeof(SerializedAlias);
+                header.existence = header.values + header.valueCount * sizeof(std::uint32_t);
+                header.handleCount = static_cast<std::uint32_t>(cli.m_options.size());
+                header.handles = header.existence + (header.optionCount + 31) / 32 * sizeof(std::uint32_t);
+                const std::uint32_t strings = header.handles + header.handleCount * sizeof(std::uint32_t);
+
+                std::string buffer(strings + 1, '\0');
+                auto appendString = [&buffer, strings](const char* str) {
+                    if (*str == '\0')
+                        return strings;
+                    auto offset = static_cast<std::uint32_t>(buffer.size());
+                    buffer.append(str, std::strlen(str) + 1);
+                    return offset;
+                };
+                // Buffer grows while strings are appended, records are written last
+                std::vector<SerializedOption> optionRecords(options.size());
+                std::vector<SerializedAlias> aliasRecords(aliases.size());
+                std::vector<std::uint32_t> valueRecords;
+                std::vector<std::uint32_t> existence((header.optionCount + 31) / 32, 0);
+                // Record of each handle
+                std::vector<std::uint32_t> handles(header.handleCount, 0);
+                valueRecords.reserve(valueCount);
+                for (size_t i = 0; i < options.size(); ++i)
+                {
+                    const Option& option = *options[i].second;
+                    auto& record = optionRecords[i];
+                    record.key = appendString(options[i].first);
+                    record.firstValue = static_cast<std::uint32_t>(valueRecords.size());
+                    record.valueCount = static_cast<std::uint32_t>(option.Values.size());
+                    record.existsCount = option.ExistsCount;
+                    for (const char* value : option.Values)
+                        valueRecords.push_back(appendString(value));
+                    record.value = !option.Values.empty() && option.Values.back() == option.Value ? valueRecords.back() : appendString(option.Value);
+                    if (option.Exists)
+                        existence[i / 32] |= std::uint32_t(1) << (i % 32);
+                    if (option.Handle.index < handles.size())
+                        handles[option.Handle.index] = static_cast<std::uint32_t>(i);
+                }
+                for (size_t i = 0; i < aliases.size(); ++i)
+                    aliasRecords[i] = { appendString(aliases[i].first), aliases[i].second };
+
+                header.size = static_cast<std::uint32_t>(buffer.size());
+                std::memcpy(&buffer[0], &header, sizeof(header));
+                if (!optionRecords.empty())
+                    std::memcpy(&buffer[header.options], optionRecords.data(), optionRecords.size() * sizeof(SerializedOption));
+                if (!aliasRecords.empty())
+                    std::memcpy(&buffer[header.aliases], aliasRecords.data(), aliasRecords.size() * sizeof(SerializedAlias));
+                if (!valueRecords.empty())
+                    std::memcpy(&buffer[header.values], valueRecords.data(), valueRecords.size() * sizeof(std::uint32_t));
+                if (!existence.empty())
+                    std::memcpy(&buffer[header.existence], existence.data(), existence.size() * sizeof(std::uint32_t));
+                if (!handles.empty())
+                    std::memcpy(&buffer[header.handles], handles.data(), handles.size() * sizeof(std::uint32_t));
+                return buffer;
+            }
+        };
+    }
+
+    // Values of a serialized option, read directly from the serialized buffer
+    class SerializedValues
+    {
+    public:
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = const char*;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const char**;
+            using reference = const char*;
+
+            iterator(const char* base, const std::uint32_t* offset) : base(base), offset(offset) {}
+            const char* operator*() const { return base + *offset; }
+            iterator& operator++() { ++offset; return *this; }
+            iterator operator++(int) { iterator it = *this; ++offset; return it; }
+            bool operator==(const iterator& other) const { return offset == other.offset; }
+            bool operator!=(const iterator& other) const { return offset != other.offset; }
+        private:
+            const char* base;
+            const std::uint32_t* offset;
+        };
+
+        SerializedValues(const char* base, const std::uint32_t* offsets, size_t count) : base(base), offsets(offsets), count(count) {}
+        inline size_t size() const { return count; }
+        inline bool empty() const { return count == 0; }
+        inline const char* operator[](size_t index) const { return base + offsets[index]; }
+        inline iterator begin() const { return { base, offsets }; }
+        inline iterator end() const { return { base, offsets + count }; }
+
+    private:
+        const char* base;
+        const std::uint32_t* offsets;
+        size_t count;
+    };
+
+    // Read only view of a serialized Cli, lookups do not parse, convert or allocate.
+    // Accessors behave like the accessors of the serialized Cli.
+    class CliView
+    {
+    public:
+        CliView(const void* data, size_t size)
+            : m_base(static_cast<const char*>(data))
+        {
+            if (size < sizeof(_detail::SerializedHeader) || reinterpret_cast<std::uintptr_t>(data) % alignof(std::uint32_t) != 0)
+                BazPO_THROW(_detail::SerializationError("Serialized options are truncated or misaligned"));
+            m_header = reinterpret_cast<const _detail::SerializedHeader*>(m_base);
+            if (m_header->magic != _detail::SerializedHeader::Magic || m_header->version != _detail::SerializedHeader::Version)
+                BazPO_THROW(_detail::SerializationError("Serialized options have an unknown format"));
+            if (m_header->size > size)
+                BazPO_THROW(_detail::SerializationError("Serialized options are truncated or misaligned"));
+            if (!validLayout())
+                BazPO_THROW(_detail::SerializationError("Serialized options are corrupt"));
+            m_options = reinterpret_cast<const _detail::SerializedOption*>(m_base + m_header->options);
+            m_aliases = reinterpret_cast<const _detail::SerializedAlias*>(m_base + m_header->aliases);
+            m_values = reinterpret_cast<const std::uint32_t*>(m_base + m_header->values);
+            m_existence = reinterpret_cast<const std::uint32_t*>(m_base + m_header->existence);
+            m_handles = reinterpret_cast<const std::uint32_t*>(m_base + m_header->handles);
+            if (!validRecords())
+                BazPO_THROW(_detail::SerializationError("Serialized options are corrupt"));
+        }
+        CliView(const CliView&) = delete;
+        CliView(CliView&& other) noexcept
+            : m_base(other.m_base), m_header(other.m_header), m_options(other.m_options), m_aliases(other.m_aliases)
+            , m_values(other.m_values), m_existence(other.m_existence), m_handles(other.m_handles), m_output(other.m_output), m_mapping(other.m_mapping), m_mappingSize(other.m_mappingSize)
+        {
+            other.m_mapping = nullptr;
+        }
+        ~CliView()
+        {
+#if !defined(_WIN32)
+            if (m_mapping != nullptr)
+                ::munmap(m_mapping, m_mappingSize);
+#endif
+        }
+
+#if !defined(_WIN32)
+        // Maps the serialized options in the file read only, e.g. a memfd inherited from the parent process
+        static CliView attach(int fd)
+        {
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(_detail::SerializedHeader)))
+                BazPO_THROW(_detail::SerializationError("Serialized options are truncated or misaligned"));
+            auto size = static_cast<size_t>(st.st_size);
+            void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping == MAP_FAILED)
+                BazPO_THROW(_detail::SerializationError("Unable to map serialized options"));
+#ifdef BazPO_DISABLE_EXCEPTIONS
+            CliView view(mapping, size);
+            view.m_mapping = mapping;
+            view.m_mappingSize = size;
+            return view;
+#else
+            try
+            {
+                CliView view(mapping, size);
+                view.m_mapping = mapping;
+                view.m_mappingSize = size;
+                return view;
+            }
+            catch (...)
+            {
+                ::munmap(mapping, size);
+                throw;
+            }
+#endif
+        }
+#endif
+
+        inline bool contains(const char* option) const { return find(option) != nullptr; }
+        inline bool exists(const char* option) const { return existsAt(static_cast<size_t>(at(option) - m_options)); }
+        inline int existsCount(const char* option) const { return at(option)->existsCount; }
+        inline const char* value(const char* option) const { return m_base + at(option)->value; }
+        inline SerializedValues values(const char* option) const { auto record = at(option); return { m_base, m_values + record->firstValue, record->valueCount }; }
+        template <typename T>
+        inline T valueAs(const char* option) const { return valueAt<T>(static_cast<size_t>(at(option) - m_options)); }
+        template <typename T>
+        inline std::deque<T> valuesAs(const char* option) const { return valuesAt<T>(static_cast<size_t>(at(option) - m_options)); }
+
+        // Handles of the serialized Cli index the records directly
+        inline bool exists(OptionHandle option) const { return existsAt(m_handles[option.index]); }
+        inline int existsCount(OptionHandle option) const { return m_options[m_handles[option.index]].existsCount; }
+        inline const char* value(OptionHandle option) const { return m_base + m_options[m_handles[option.index]].value; }
+        inline SerializedValues values(OptionHandle option) const { const auto& record = m_options[m_handles[option.index]]; return { m_base, m_values + record.firstValue, record.valueCount }; }
+        template <typename T>
+        inline T valueAs(OptionHandle option) const { return valueAt<T>(static_cast<size_t>(m_handles[option.index])); }
+        template <typename T>
+        inline std::deque<T> valuesAs(OptionHandle option) const { return valuesAt<T>(static_cast<size_t>(m_handles[option.index])); }
+        inline size_t size() const { return m_header->size; }
+        inline const void* data() const { return m_base; }
+#ifndef BazPO_DISABLE_IOSTREAM
+        inline void changeIO(std::ostream* ostream) { m_output.redirect(ostream); }
+#endif
+        // Conversion errors are written like the conversion errors of the Cli before the program exits
+        inline void output(WriteFunction write, void* context = nullptr) { m_output.redirect(write, context); }
+
+        // Keys of the options whose existence, count or values differ from the previous view, options missing from one of the views included
+        std::vector<std::string> changedSince(const CliView& previous) const
+        {
+            std::vector<std::string> changed;
+            const size_t count = m_header->optionCount, previousCount = previous.m_header->optionCount;
+            for (size_t i = 0, j = 0; i < count || j < previousCount;)
+            {
+                int order = i == count ? 1 : j == previousCount ? -1 : std::strcmp(key(i), previous.key(j));
+                if (order < 0)
+                    changed.emplace_back(key(i++));
+                else if (order > 0)
+                    changed.emplace_back(previous.key(j++));
+                else
+                {
+                    if (!sameOption(i, previous, j))
+                        changed.emplace_back(key(i));
+                    ++i;
+                    ++j;
+                }
+            }
+            return changed;
+        }
+
+    private:
+        inline const char* key(size_t index) const { return m_base + m_options[index].key; }
+        template <typename T>
+        T valueAt(size_t index) const
+        {
+            const char* value = m_base + m_options[index].value;
+            auto valPair = _detail::valueAs<T>(value);
+            if (valPair.second)
+                conversionError(value, key(index));
+            return valPair.first;
+        }
+        template <typename T>
+        std::deque<T> valuesAt(size_t index) const
+        {
+            std::deque<T> ret;
+            const auto& record = m_options[index];
+            for (std::uint32_t i = 0; i < record.valueCount; ++i)
+            {
+                const char* value = m_base + m_values[record.firstValue + i];
+                auto valPair = _detail::valueAs<T>(value);
+                if (valPair.second)
+                    conversionError(value, key(index));
+                ret.emplace_back(valPair.first);
+            }
+            return ret;
+        }
+        inline bool existsAt(size_t index) const { return (m_existence[index / 32] >> (index % 32)) & 1; }
+        bool sameOption(size_t index, const CliView& other, size_t otherIndex) const
+        {
+            const auto& record = m_options[index];
+            const auto& otherRecord = other.m_options[otherIndex];
+            if (existsAt(index) != other.existsAt(otherIndex) || record.existsCount != otherRecord.existsCount || record.valueCount != otherRecord.valueCount
+                || std::strcmp(m_base + record.value, other.m_base + otherRecord.value) != 0)
+                return false;
+            for (std::uint32_t i = 0; i < record.valueCount; ++i)
+                if (std::strcmp(m_base + m_values[record.firstValue + i], other.m_base + other.m_values[otherRecord.firstValue + i]) != 0)
+                    return false;
+            return true;
+        }
+        const _detail::SerializedOption* find(const char* option) const
+        {
+            auto aliasEnd = m_aliases + m_header->aliasCount;
+            auto alias = std::lower_bound(m_aliases, aliasEnd, option, [this](const _detail::SerializedAlias& l, const char* r) { return std::strcmp(m_base + l.alias, r) < 0; });
+            if (alias != aliasEnd && std::strcmp(m_base + alias->alias, option) == 0)
+                return m_options + alias->option;
+            auto optionEnd = m_options + m_header->optionCount;
+            auto record = std::lower_bound(m_options, optionEnd, option, [this](const _detail::SerializedOption& l, const char* r) { return std::strcmp(m_base + l.key, r) < 0; });
+            if (record != optionEnd && std::strcmp(m_base + record->key, option) == 0)
+                return record;
+            return nullptr;
+        }
+        const _detail::SerializedOption* at(const char* option) const
+        {
+            auto record = find(option);
+            if (record == nullptr)
+                BazPO_THROW(std::out_of_range("Option is not serialized"));
+            return record;
+        }
+        [[noreturn]] void conversionError(const char* value, const char* option) const
+        {
+            m_output << "Type of value '" << value << "' is not expected for option " << option << "\n";
+            m_output.flush();
+            exit(1);
+        }
+        // Tables lie within the serialized size, aligned like their records
+        bool validLayout() const
+        {
+            const auto& header = *m_header;
+            auto within = [&header](std::uint32_t offset, std::uint64_t count, size_t recordSize) {
+                return offset >= sizeof(_detail::SerializedHeader) && offset % alignof(std::uint32_t) == 0 && offset + count * recordSize <= header.size;
+            };
+            // Strings end within the buffer when its last byte terminates them
+            return header.size > sizeof(_detail::SerializedHeader) && m_base[header.size - 1] == '\0'
+                && within(header.options, header.optionCount, sizeof(_detail::SerializedOption))
+                && within(header.aliases, header.aliasCount, sizeof(_detail::SerializedAlias))
+                && within(header.values, header.valueCount, sizeof(std::uint32_t))
+                && within(header.existence, (std::uint64_t(header.optionCount) + 31) / 32, sizeof(std::uint32_t))
+                && within(header.handles, header.handleCount, sizeof(std::uint32_t));
+        }
+        // Every string offset lies within the buffer and every index within its table
+        bool validRecords() const
+        {
+            const auto& header = *m_header;
+            for (std::uint32_t i = 0; i < header.optionCount; ++i)
+            {
+                const auto& record = m_options[i];
+                if (record.key >= header.size || record.value >= header.size || std::uint64_t(record.firstValue) + record.valueCount > header.valueCount)
+                    return false;
+            }
+            for (std::uint32_t i = 0; i < header.aliasCount; ++i)
+                if (m_aliases[i].alias >= header.size || m_aliases[i].option >= header.optionCount)
+                    return false;
+            for (std::uint32_t i = 0; i < header.valueCount; ++i)
+                if (m_values[i] >= header.size)
+                    return false;
+            for (std::uint32_t i = 0; i < header.handleCount; ++i)
+                if (m_handles[i] >= header.optionCount)
+                    return false;
+            return true;
+        }
+
+        const char* m_base;
+        const _detail::SerializedHeader* m_header;
+        const _detail::SerializedOption* m_options;
+        const _detail::SerializedAlias* m_aliases;
+        const std::uint32_t* m_values;
+        const std::uint32_t* m_existence;
+        const std::uint32_t* m_handles;
+        mutable _detail::Output m_output;
+        void* m_mapping = nullptr;
+        size_t m_mappingSize = 0;
+    };
+
+    // Compact relocatable encoding of the parsed options: records with string offsets, existence bits and counts
+    inline std::string serialize(const Cli& cli) { return _detail::Serializer::serialize(cli); }
+
+#if !defined(_WIN32)
+    // Writes the serialized options to a file, pipe or socket
+    inline void writeSerialized(const Cli& cli, int fd)
+    {
+        auto buffer = serialize(cli);
+        for (size_t written = 0; written < buffer.size();)
+        {
+            auto result = ::write(fd, buffer.data() + written, buffer.size() - written);
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result <= 0)
+                BazPO_THROW(_detail::SerializationError("Unable to write serialized options"));
+            written += static_cast<size_t>(result);
+        }
+    }
+    // Reads serialized options written by writeSerialized until the end of the stream, e.g. from a pipe
+    inline std::string readSerialized(int fd)
+    {
+        std::string buffer;
+        char chunk[4096];
+        for (;;)
+        {
+            auto result = ::read(fd, chunk, sizeof(chunk));
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result < 0)
+                BazPO_THROW(_detail::SerializationError("Unable to read serialized options"));
+            if (result == 0)
+                return buffer;
+            buffer.append(chunk, static_cast<size_t>(result));
+        }
+    }
+    // Anonymous file holding the serialized options, inherited by forked and executed child processes
+    inline int serializeToMemoryFile(const Cli& cli)
+    {
+#if defined(__linux__)
+        int fd = ::memfd_create("BazPO", 0);
+#else
+        char name[] = "/tmp/BazPOXXXXXX";
+        int fd = ::mkstemp(name);
+        if (fd >= 0)
+            ::unlink(name);
+#endif
+        if (fd < 0)
+            BazPO_THROW(_detail::SerializationError("Unable to create serialized options file"));
+#ifdef BazPO_DISABLE_EXCEPTIONS
+        writeSerialized(cli, fd);
+#else
+        try
+        {
+            writeSerialized(cli, fd);
+        }
+        catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+#endif
+        return fd;
+    }
+#endif
+}
+
+#endif
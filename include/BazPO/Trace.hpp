@@ -0,0 +1,157 @@
+#ifndef BAZ_PO_TRACE_HPP
+#define BAZ_PO_TRACE_HPP
+
+/*
+BazPO Chrome trace recorder.
+Copyright (c) 2022 Baris Tanyeri
+https://github.com/karusb/BazPO
+MIT License
+*/
+
+// Spans are reported by the parse observer, every translation unit including BazPO has to be built with BazPO_ENABLE_PARSE_TIMING
+#if defined(BAZ_PO_CORE_HPP) && !defined(BazPO_ENABLE_PARSE_TIMING)
+#error "BazPO/Trace.hpp requires BazPO_ENABLE_PARSE_TIMING to be defined before BazPO.hpp is included"
+#endif
+#ifndef BazPO_ENABLE_PARSE_TIMING
+#define BazPO_ENABLE_PARSE_TIMING
+#endif
+
+#include "../BazPO.hpp"
+#include <atomic>
+#include <thread>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace BazPO
+{
+    // Records registration, option registrations, parse phases, constraint evaluations and option functions as Chrome trace events,
+    // written as JSON to the file named by the environment variable. Nothing is recorded when the variable is not set.
+    // Events and their names are written to fixed buffers without locks, events beyond the capacity or whose name does not fit are dropped.
+    // Timestamps are std::chrono::steady_clock microseconds, spans of the program on the same clock line up with the parse.
+    class TraceRecorder
+        : public ParseObserver
+    {
+    public:
+        // Names are copied whole, the name buffer holds 64 bytes per event
+        explicit TraceRecorder(const char* environmentVariable = "BAZPO_TRACE_FILE", size_t capacity = 1024)
+            : path(std::getenv(environmentVariable))
+            , capacity(path != nullptr ? capacity : 0)
+            , events(new Event[this->capacity])
+            , namesCapacity(this->capacity * 64)
+            , names(new char[namesCapacity])
+        {}
+        TraceRecorder(const TraceRecorder&) = delete;
+        ~TraceRecorder() override { flush(); }
+
+        inline bool enabled() const { return path != nullptr; }
+        inline size_t dropped() const
+        {
+            auto recorded = next.load();
+            return (recorded > capacity ? recorded - capacity : 0) + unnamed.load();
+        }
+
+        virtual void phase(Phase phase, std::chrono::nanoseconds duration) override { record("phase", phaseName(phase), SIZE_MAX, duration); }
+        virtual void callback(const Option& option, const char* parameter, std::chrono::nanoseconds duration) override { record("callback", parameter, option.values().size(), duration); }
+        virtual void constraint(const Option& /*option*/, const char* parameter, size_t valueCount, std::chrono::nanoseconds duration) override { record("constraint", parameter, valueCount, duration); }
+        virtual void registration(const Option& /*option*/, const char* parameter, std::chrono::nanoseconds duration) override { record("registration", parameter, SIZE_MAX, duration); }
+
+        // Writes the events recorded so far, the destructor writes them as well. Returns false when the file can not be written.
+        bool flush() const
+        {
+            if (path == nullptr)
+                return true;
+            FILE* file = std::fopen(path, "w");
+            if (file == nullptr)
+                return false;
+#if defined(_WIN32)
+            const long long pid = _getpid();
+#else
+            const long long pid = ::getpid();
+#endif
+            std::fputs("{\"traceEvents\":[", file);
+            const char* separator = "\n";
+            const size_t count = std::min(next.load(), capacity);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const auto& event = events[i];
+                if (!event.ready.load(std::memory_order_acquire))
+                    continue;
+                std::fprintf(file, "%s{\"name\":\"", separator);
+                writeEscaped(file, event.name);
+                std::fprintf(file, "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lld,\"tid\":%llu",
+                    event.category, event.start / 1000.0, event.duration / 1000.0, pid, static_cast<unsigned long long>(event.thread));
+                if (event.valueCount != SIZE_MAX)
+                    std::fprintf(file, ",\"args\":{\"values\":%llu}", static_cast<unsigned long long>(event.valueCount));
+                std::fputs("}", file);
+                separator = ",\n";
+            }
+            std::fputs("\n]}\n", file);
+            return std::fclose(file) == 0;
+        }
+
+    private:
+        struct Event
+        {
+            std::atomic<bool> ready{ false };
+            const char* category = "";
+            const char* name = "";
+            long long start = 0;
+            long long duration = 0;
+            size_t thread = 0;
+            size_t valueCount = SIZE_MAX;
+        };
+
+        void record(const char* category, const char* name, size_t valueCount, std::chrono::nanoseconds duration)
+        {
+            if (path == nullptr)
+                return;
+            auto end = std::chrono::steady_clock::now().time_since_epoch();
+            // A truncated name could collide with the name of another span, the event is dropped instead
+            const size_t nameSize = std::strlen(name) + 1;
+            auto nameOffset = namesUsed.fetch_add(nameSize);
+            if (nameOffset + nameSize > namesCapacity)
+            {
+                unnamed.fetch_add(1);
+                return;
+            }
+            auto index = next.fetch_add(1);
+            if (index >= capacity)
+                return;
+            auto& event = events[index];
+            event.category = category;
+            event.name = static_cast<const char*>(std::memcpy(&names[nameOffset], name, nameSize));
+            event.start = static_cast<long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - duration).count());
+            event.duration = static_cast<long long>(duration.count());
+            event.thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+            event.valueCount = valueCount;
+            event.ready.store(true, std::memory_order_release);
+        }
+        static void writeEscaped(FILE* file, const char* text)
+        {
+            for (; *text != '\0'; ++text)
+            {
+                if (*text == '"' || *text == '\\')
+                    std::fputc('\\', file);
+                if (static_cast<unsigned char>(*text) < 0x20)
+                    std::fprintf(file, "\\u%04x", static_cast<unsigned>(*text));
+                else
+                    std::fputc(*text, file);
+            }
+        }
+
+        const char* path;
+        const size_t capacity;
+        std::unique_ptr<Event[]> events;
+        std::atomic<size_t> next{ 0 };
+        const size_t namesCapacity;
+        std::unique_ptr<char[]> names;
+        std::atomic<size_t> namesUsed{ 0 };
+        std::atomic<size_t> unnamed{ 0 };
+    };
+}
+
+#endif
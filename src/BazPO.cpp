@@ -0,0 +1,10 @@
+// BazPO.cpp : Parser of the BazPO::compiled library, programs linking it include BazPO.hpp without the parser definitions.
+//
+
+#define BazPO_INLINE
+#include "../include/BazPO/CoreImpl.hpp"
+
+namespace BazPO
+{
+    BazPO_INSTANTIATE_ALL()
+}
@@ -0,0 +1,40 @@
+// Second translation unit including the headers, linking it with test.cpp checks that every definition is inline or compiled once
+#include "gtest/gtest.h"
+#include "../include/BazPO.hpp"
+#include "../include/BazPO/ConfigFile.hpp"
+#include "../include/BazPO/Serialization.hpp"
+#include "../include/BazPO/FileOption.hpp"
+#include "../include/BazPO/EnumOption.hpp"
+#include "../include/BazPO/MapOption.hpp"
+#include "../include/BazPO/Parallel.hpp"
+#include "../include/BazPO/Async.hpp"
+
+using namespace BazPO;
+
+TEST(CompiledTest, options_are_parsed_from_another_translation_unit)
+{
+    int argc = 6;
+    const char* argv[6]{ {"programoptions"}, {"-a"}, {"Aoption"}, {"-n"}, {"15"}, {"-f"} };
+    Cli po{ argc, argv };
+    po.option("-a", "--alpha", "Option A");
+    auto& number = po.typedOption<int>("-n");
+    FlagOption flag(&po, "-f");
+
+    po.parse();
+
+    EXPECT_STREQ("Aoption", po.getOption("-a").value());
+    EXPECT_EQ(15, number.get());
+    EXPECT_TRUE(flag.exists());
+}
+
+TEST(CompiledTest, typed_options_of_other_types_are_instantiated_in_the_program)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-s"}, {"7"} };
+    Cli po{ argc, argv };
+    TypedOption<short> s(&po, "-s");
+
+    po.parse();
+
+    EXPECT_EQ(7, s.get());
+}
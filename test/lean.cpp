@@ -0,0 +1,101 @@
+#define BazPO_LEAN
+#include "gtest/gtest.h"
+#include "../include/BazPO.hpp"
+#include "../include/BazPO/ConfigFile.hpp"
+#include "../include/BazPO/Serialization.hpp"
+
+using namespace BazPO;
+
+namespace
+{
+    void append(void* context, const char* data, size_t size) { static_cast<std::string*>(context)->append(data, size); }
+    void writeStandardError(void*, const char* data, size_t size) { std::fwrite(data, 1, size, stderr); }
+}
+
+TEST(LeanCliTest, numbers_are_converted_without_streams)
+{
+    int argc = 11;
+    const char* argv[11]{ {"programoptions"}, {"-i"}, {"-42"}, {"-u"}, {"42"}, {"-d"}, {"15.2156"}, {"-c"}, {" x"}, {"-s"}, {"70000"} };
+    Cli po{ argc, argv };
+    TypedOption<int> i(&po, "-i");
+    TypedOption<unsigned> u(&po, "-u");
+    TypedOption<double> d(&po, "-d");
+    TypedOption<char> c(&po, "-c");
+    TypedOption<short> s(&po, "-s");
+    std::string written;
+    po.output(append, &written);
+
+    auto result = po.tryParse();
+
+    EXPECT_EQ(-42, i.get());
+    EXPECT_EQ(42u, u.get());
+    EXPECT_EQ(15.2156, d.get());
+    EXPECT_EQ('x', c.get());
+    // Out of range for short
+    ASSERT_EQ(1u, result.diagnostics().size());
+    EXPECT_EQ(Diagnostic::Kind::InvalidValue, result.diagnostics()[0].kind);
+}
+
+TEST(LeanCliTest, invalid_numbers_are_rejected)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"-i"}, {"abc"}, {"-u"}, {"99999999999999999999"} };
+    Cli po{ argc, argv };
+    TypedOption<int> i(&po, "-i");
+    TypedOption<unsigned> u(&po, "-u");
+    std::string written;
+    po.output(append, &written);
+
+    auto result = po.tryParse();
+
+    EXPECT_EQ(2u, result.diagnostics().size());
+}
+
+TEST(LeanCliTest, help_is_written_to_the_write_function)
+{
+    int argc = 2;
+    const char* argv[2]{ {"programoptions"}, {"-h"} };
+    Cli po{ argc, argv, "Program Description" };
+    po.option("-a", "--alpha", "Option A");
+    std::string written;
+    po.output(append, &written);
+
+    auto result = po.tryParse();
+
+    EXPECT_TRUE(result.helpRequested());
+    EXPECT_NE(std::string::npos, written.find("usage: programoptions"));
+    EXPECT_NE(std::string::npos, written.find("[-a]"));
+}
+
+TEST(LeanCliTest, prioritizing_tagless_option_aborts)
+{
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    Cli po{ argc, argv };
+    auto& tagless = po.tagless();
+
+    EXPECT_DEATH(tagless.prioritize(), "Tagless options cannot be prioritized!");
+}
+
+TEST(LeanCliTest, config_file_errors_abort)
+{
+    const std::string missing = testing::TempDir() + "bazpo_lean_missing.conf";
+
+    EXPECT_DEATH(ConfigFile::load(missing), "Unable to open configuration file");
+}
+
+TEST(LeanCliTest, serialized_view_conversion_errors_are_written_to_the_write_function)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-a"}, {"Aoption"} };
+    Cli po{ argc, argv };
+    po.option("-a", "--alpha");
+    po.tryParse();
+    auto buffer = serialize(po);
+    CliView view(buffer.data(), buffer.size());
+    view.output(writeStandardError);
+
+    EXPECT_STREQ("Aoption", view.value("--alpha"));
+    EXPECT_EXIT(view.valueAs<int>("-a"), testing::ExitedWithCode(1), "Type of value 'Aoption' is not expected for option -a");
+    EXPECT_DEATH(CliView(buffer.data(), buffer.size() - 1), "Serialized options are truncated or misaligned");
+}
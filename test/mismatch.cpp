@@ -0,0 +1,10 @@
+// Built only by the link check test: a program timing the parse must not link the parser built without timing
+#define BazPO_ENABLE_PARSE_TIMING
+#include "../include/BazPO.hpp"
+
+int main(int argc, const char* argv[])
+{
+    BazPO::Cli po{ argc, argv };
+    po.parse();
+    return 0;
+}
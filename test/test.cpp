@@ -1,6 +1,26 @@
 #include "gtest/gtest.h"
 #include "../include/BazPO.hpp"
+#include "../include/BazPO/ConfigFile.hpp"
+#include "../include/BazPO/Serialization.hpp"
+#include "../include/BazPO/FileOption.hpp"
+#include "../include/BazPO/EnumOption.hpp"
+#include "../include/BazPO/MapOption.hpp"
+#include "../include/BazPO/Parallel.hpp"
+#include "../include/BazPO/Async.hpp"
+#include "../include/BazPO/Reload.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <set>
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 using namespace BazPO;
 
@@ -15,8 +35,38 @@ public:
     void ExpectOptionExistsWithValue(const Option& option, std::string expectedValue);
     void ExpectOptionExistsWithValues(Cli& cli, std::string optionKey, std::deque<std::string> expectedValues);
     void ExpectOptionExistsWithValues(const Option& option, std::deque<std::string> expectedValues);
+    std::string TempName(const std::string& name);
+    std::string WriteFile(const std::string& name, const std::string& contents);
+    void TearDown() override
+    {
+        for (const auto& path : writtenFiles)
+            std::remove(path.c_str());
+    }
+
+private:
+    std::vector<std::string> writtenFiles;
 };
 
+// Unique per process and test, the same tests run in several binaries at the same time
+std::string ProgramOptionsTest::TempName(const std::string& name)
+{
+#if defined(_WIN32)
+    const int pid = _getpid();
+#else
+    const int pid = static_cast<int>(::getpid());
+#endif
+    return std::to_string(pid) + "_" + testing::UnitTest::GetInstance()->current_test_info()->name() + "_" + name;
+}
+
+std::string ProgramOptionsTest::WriteFile(const std::string& name, const std::string& contents)
+{
+    std::string path = testing::TempDir() + TempName(name);
+    writtenFiles.push_back(path);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << contents;
+    return path;
+}
+
 
 void ProgramOptionsTest::ExpectValues(const Option& option, std::deque<std::string> expectedValues)
 {
@@ -1199,6 +1249,23 @@ TEST_F(ProgramOptionsTest, constrained_min_max_values_exits_on_invalid_conversio
     EXPECT_EXIT(po.parse(), testing::ExitedWithCode(1), "");
 }
 
+TEST_F(ProgramOptionsTest, constrained_min_max_values_report_conversion_errors_as_invalid_values)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"-a"}, {"Aoption"}, {"-a"}, {"5"} };
+    Cli po{ argc, argv };
+    MultiOption optiona(&po, "-a", "--alpha", "Option A");
+    MinMaxConstraint<double> constraint(optiona, { 0.00001, 1.95 });
+
+    auto result = po.tryParse();
+    ASSERT_EQ(2u, result.diagnostics().size());
+    EXPECT_EQ(Diagnostic::Kind::InvalidValue, result.diagnostics()[0].kind);
+    EXPECT_EQ(2, result.diagnostics()[0].argIndex);
+    EXPECT_EQ("Type of value 'Aoption' is not expected for option -a", result.diagnostics()[0].message());
+    EXPECT_EQ(Diagnostic::Kind::ConstraintViolation, result.diagnostics()[1].kind);
+    EXPECT_EQ(4, result.diagnostics()[1].argIndex);
+}
+
 TEST_F(ProgramOptionsTest, constrained_under_min_value_exits)
 {
     int argc = 3;
@@ -1382,3 +1449,1584 @@ TEST_F(ProgramOptionsTest, tagless_options_print)
     po.tagless(4, "Fourth set of values").withMaxValueCount(SIZE_MAX);
     po.printOptions();
 }
+
+TEST_F(ProgramOptionsTest, config_file_values_used_when_not_provided)
+{
+    auto path = WriteFile("bazpo_config_values.conf", "# comment\nalpha = Aoption\n; comment\n-b=Boption\n\n[server]\nthreads = 8\nverbose\nname = \"quoted value\"");
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    Cli po{ argc, argv };
+    po.option("-a", "--alpha", "Option A");
+    po.option("-b", "--bravo", "Option B");
+    po.option("--server.threads");
+    po.option("--server.name");
+    po.flag("--server.verbose");
+    po.source(ConfigFile::load(path));
+    po.parse();
+
+    ExpectOptionExistsWithValue(po, "-a", "Aoption");
+    ExpectOptionExistsWithValue(po, "-b", "Boption");
+    ExpectOptionExistsWithValue(po, "--server.name", "quoted value");
+    EXPECT_EQ(8, po.valueAs<int>("--server.threads"));
+    EXPECT_TRUE(po.exists("--server.verbose"));
+}
+
+TEST_F(ProgramOptionsTest, config_file_arguments_take_precedence)
+{
+    auto system = WriteFile("bazpo_config_system.conf", "alpha = system\nbravo = system\ncharlie = system\ndelta = 1\ndelta = 2\n");
+    auto user = WriteFile("bazpo_config_user.conf", "bravo = user\ncharlie = user\n");
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-c"}, {"argument"} };
+    Cli po{ argc, argv };
+    po.option("-a", "--alpha");
+    po.option("-b", "--bravo");
+    po.option("-c", "--charlie");
+    po.option("-d", "--delta", "", "", OptionType::MultiValue);
+    po.source(ConfigFile::load(system));
+    po.source(ConfigFile::load(user));
+    po.parse();
+
+    ExpectOptionExistsWithValue(po, "-a", "system");
+    ExpectOptionExistsWithValue(po, "-b", "user");
+    ExpectOptionExistsWithValues(po, "-c", { "argument" });
+    ExpectOptionExistsWithValues(po, "-d", { "1", "2" });
+}
+
+TEST_F(ProgramOptionsTest, config_file_includes_and_cache)
+{
+    WriteFile("bazpo_config_included.conf", "[included]\nvalue = from include\n");
+    auto path = WriteFile("bazpo_config_including.conf", "alpha = main\n@include " + TempName("bazpo_config_included.conf") + "\n");
+    auto first = ConfigFile::load(path);
+    auto second = ConfigFile::load(path);
+    EXPECT_EQ(first.get(), second.get());
+
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    Cli po{ argc, argv };
+    po.option("--alpha");
+    po.option("--included.value");
+    po.source(first);
+    po.parse();
+
+    ExpectOptionExistsWithValue(po, "--alpha", "main");
+    ExpectOptionExistsWithValue(po, "--included.value", "from include");
+}
+
+TEST_F(ProgramOptionsTest, config_file_modified_replaces_cached_version)
+{
+    auto path = WriteFile("bazpo_config_modified.conf", "alpha = 1\n");
+    std::weak_ptr<const ConfigFile> previous = ConfigFile::load(path);
+    EXPECT_FALSE(previous.expired());
+    WriteFile("bazpo_config_modified.conf", "alpha = 22\n");
+    auto current = ConfigFile::load(path);
+
+    // The cache keeps only the current version
+    EXPECT_TRUE(previous.expired());
+    EXPECT_EQ("22", current->entries()[0].value.str());
+
+    // Large files are mapped
+    auto large = WriteFile("bazpo_config_large.conf", std::string(_detail::MappedFile::ReadLimit, '#') + "\nalpha = large\n");
+    EXPECT_EQ("large", ConfigFile::load(large)->entries()[0].value.str());
+}
+
+TEST_F(ProgramOptionsTest, config_file_errors)
+{
+    EXPECT_THROW(ConfigFile::load(testing::TempDir() + TempName("bazpo_config_missing.conf")), _detail::ConfigFileError);
+    auto cyclic = WriteFile("bazpo_config_cyclic.conf", "@include " + TempName("bazpo_config_cyclic.conf") + "\n");
+    EXPECT_THROW(ConfigFile::load(cyclic), _detail::ConfigFileError);
+
+    auto unknown = WriteFile("bazpo_config_unknown.conf", "unknown = value\n");
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    Cli po{ argc, argv };
+    po.source(ConfigFile::load(unknown));
+    EXPECT_EXIT(po.parse(), testing::ExitedWithCode(1), "");
+}
+
+TEST_F(ProgramOptionsTest, subcommand_options_registered_only_when_selected)
+{
+    int argc = 6;
+    const char* argv[6]{ {"programoptions"}, {"-v"}, {"build"}, {"-j"}, {"8"}, {"-v"} };
+    int buildRegistered = 0;
+    int testRegistered = 0;
+    Cli po{ argc, argv };
+    po.flag("-v", "Verbose");
+    po.subcommand("build", [&](Cli& build) {
+        ++buildRegistered;
+        build.option("-j", "--jobs", "Job count");
+        build.flag("-v", "Verbose build");
+        }, "Builds the project");
+    po.subcommand("test", [&](Cli& test) {
+        ++testRegistered;
+        test.option("-f", "--filter");
+        }, "Runs the tests");
+    po.parse();
+
+    EXPECT_EQ(1, buildRegistered);
+    EXPECT_EQ(0, testRegistered);
+    EXPECT_EQ(1, po.getOption("-v").existsCount());
+    ASSERT_NE(nullptr, po.selectedSubcommand());
+    EXPECT_STREQ("build", po.selectedSubcommandName());
+    EXPECT_EQ(8, po.selectedSubcommand()->valueAs<int>("--jobs"));
+    EXPECT_TRUE(po.selectedSubcommand()->exists("-v"));
+}
+
+TEST_F(ProgramOptionsTest, subcommand_reads_its_config_file_section)
+{
+    auto path = WriteFile("bazpo_config_subcommand.conf", "verbose\n[build]\njobs = 4\ntarget = all\n[test]\nfilter = fast\n");
+    int argc = 4;
+    const char* argv[4]{ {"programoptions"}, {"build"}, {"--target"}, {"lib"} };
+    Cli po{ argc, argv };
+    po.flag("-v", "Verbose", "--verbose");
+    po.subcommand("build", [](Cli& build) {
+        build.option("-j", "--jobs");
+        build.option("-t", "--target");
+        });
+    po.subcommand("test", [](Cli& test) { test.option("-f", "--filter"); });
+    po.source(ConfigFile::load(path));
+    po.parse();
+
+    EXPECT_TRUE(po.exists("-v"));
+    ASSERT_NE(nullptr, po.selectedSubcommand());
+    EXPECT_EQ(4, po.selectedSubcommand()->valueAs<int>("--jobs"));
+    ExpectOptionExistsWithValue(*po.selectedSubcommand(), "--target", "lib");
+}
+
+TEST_F(ProgramOptionsTest, subcommand_not_selected_by_option_value)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"-a"}, {"build"}, {"test"}, {"-f"} };
+    Cli po{ argc, argv };
+    po.option("-a", "--alpha");
+    po.subcommand("build", [](Cli&) {});
+    po.subcommand("test", [](Cli& test) { test.flag("-f"); });
+    po.parse();
+
+    ExpectOptionExistsWithValue(po, "-a", "build");
+    EXPECT_STREQ("test", po.selectedSubcommandName());
+    EXPECT_TRUE(po.selectedSubcommand()->exists("-f"));
+}
+
+TEST_F(ProgramOptionsTest, subcommand_unknown_arguments_exit)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"build"}, {"-x"} };
+    Cli po{ argc, argv };
+    po.subcommand("build", [](Cli&) {});
+
+    EXPECT_EXIT(po.parse(), testing::ExitedWithCode(1), "");
+}
+
+TEST_F(ProgramOptionsTest, subcommand_help_exits)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"build"}, {"-h"} };
+    Cli po{ argc, argv };
+    po.option("-a", "--alpha").mandatory();
+    po.subcommand("build", [](Cli&) {}, "Builds the project");
+
+    EXPECT_EXIT(po.parse(), testing::ExitedWithCode(0), "");
+}
+
+TEST_F(ProgramOptionsTest, completion_lists_matching_options)
+{
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    Cli po{ argc, argv };
+    po.option("-a", "--alpha", "Option A").mandatory();
+    po.option("-b", "--bravo", "Option B");
+    po.flag("--all");
+    po.tagless();
+
+    const char* words[1]{ {"--a"} };
+    EXPECT_EQ("--all\n--alpha\n", po.completions(1, words));
+    const char* empty[1]{ {""} };
+    EXPECT_EQ("--all\n-a\n--alpha\n-b\n--bravo\n-h\n--help\n", po.completions(1, empty));
+}
+
+TEST_F(ProgramOptionsTest, completion_lists_constrained_values)
+{
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    Cli po{ argc, argv };
+    po.option("-m", "--mode").constrain({ "fast", "slow", "safe" });
+    po.option("-f", "--file");
+
+    const char* words[2]{ {"--mode"}, {"s"} };
+    EXPECT_EQ("slow\nsafe\n", po.completions(2, words));
+    const char* file[2]{ {"-f"}, {"s"} };
+    EXPECT_EQ("", po.completions(2, file));
+    const char* option[3]{ {"-f"}, {"x"}, {"--m"} };
+    EXPECT_EQ("--mode\n", po.completions(3, option));
+}
+
+TEST_F(ProgramOptionsTest, completion_descends_into_subcommand)
+{
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    Cli po{ argc, argv };
+    po.option("-j");
+    po.subcommand("build", [](Cli& build) { build.option("--target"); });
+    po.subcommand("bench", [](Cli& bench) { bench.option("--filter"); });
+
+    const char* subcommands[1]{ {"b"} };
+    EXPECT_EQ("bench\nbuild\n", po.completions(1, subcommands));
+    const char* words[2]{ {"build"}, {"--t"} };
+    EXPECT_EQ("--target\n", po.completions(2, words));
+}
+
+TEST_F(ProgramOptionsTest, completion_mode_skips_parsing)
+{
+    int argc = 4;
+    const char* argv[4]{ {"programoptions"}, {"__complete"}, {"--unknown"}, {"--al"} };
+    bool executed = false;
+    Cli po{ argc, argv };
+    po.option("-a", [&](const Option&) { executed = true; }, "--alpha").mandatory();
+
+    EXPECT_EXIT(po.parse(), testing::ExitedWithCode(0), "");
+    EXPECT_FALSE(executed);
+    EXPECT_NE(std::string::npos, po.completionScript(Shell::Bash).find("complete -o default -F _bazpo_programoptions programoptions"));
+    EXPECT_NE(std::string::npos, po.completionScript(Shell::Zsh).find("compdef _bazpo_programoptions programoptions"));
+}
+
+TEST_F(ProgramOptionsTest, serialized_view_matches_cli)
+{
+    int argc = 9;
+    const char* argv[9]{ {"programoptions"}, {"-a"}, {"Aoption"}, {"-m"}, {"1"}, {"2"}, {"3"}, {"-f"}, {"-f"} };
+    Cli po{ argc, argv };
+    po.option("-a", "--alpha", "Option A");
+    po.option("-b", "--bravo", "Option B", "default");
+    po.option("-m", "--multi", "Multi", "", OptionType::MultiValue);
+    po.flag("-f", "Flag", "--flag");
+    po.parse();
+
+    auto buffer = serialize(po);
+    CliView view(buffer.data(), buffer.size());
+    for (const char* key : { "-a", "--alpha", "-b", "--bravo", "-m", "--multi", "-f", "--flag", "-h" })
+    {
+        EXPECT_EQ(po.exists(key), view.exists(key));
+        EXPECT_EQ(po.getOption(key).existsCount(), view.existsCount(key));
+        EXPECT_STREQ(po.getOption(key).value(), view.value(key));
+        ExpectValues(po.getOption(key), std::deque<std::string>(view.values(key).begin(), view.values(key).end()));
+    }
+    EXPECT_EQ(po.getOption("-m").valuesAs<int>(), view.valuesAs<int>("--multi"));
+    EXPECT_EQ(3, view.valueAs<int>("-m"));
+    EXPECT_FALSE(view.contains("-x"));
+    EXPECT_THROW(view.exists("-x"), std::out_of_range);
+    EXPECT_THROW(CliView(buffer.data(), 8), _detail::SerializationError);
+}
+
+TEST_F(ProgramOptionsTest, serialized_view_rejects_corrupt_offsets)
+{
+    int argc = 6;
+    const char* argv[6]{ {"programoptions"}, {"-a"}, {"Aoption"}, {"-m"}, {"1"}, {"2"} };
+    Cli po{ argc, argv };
+    po.option("-a", "--alpha", "Option A");
+    po.option("-m", "--multi", "Multi", "", OptionType::MultiValue);
+    po.parse();
+    const auto buffer = serialize(po);
+    _detail::SerializedHeader header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    auto corrupt = [&buffer](size_t offset, std::uint32_t value) {
+        std::vector<std::uint32_t> storage((buffer.size() + 3) / 4);
+        std::memcpy(storage.data(), buffer.data(), buffer.size());
+        std::memcpy(reinterpret_cast<char*>(storage.data()) + offset, &value, sizeof(value));
+        CliView view(storage.data(), buffer.size());
+    };
+    const size_t firstOption = header.options, firstAlias = header.aliases;
+
+    EXPECT_THROW(CliView(buffer.data(), buffer.size() - 1), _detail::SerializationError);
+    EXPECT_THROW(corrupt(offsetof(_detail::SerializedHeader, optionCount), 1000000), _detail::SerializationError);
+    EXPECT_THROW(corrupt(offsetof(_detail::SerializedHeader, values), header.size - 2), _detail::SerializationError);
+    EXPECT_THROW(corrupt(offsetof(_detail::SerializedHeader, handles), 0xFFFFFFF0u), _detail::SerializationError);
+    EXPECT_THROW(corrupt(firstOption + offsetof(_detail::SerializedOption, key), header.size), _detail::SerializationError);
+    EXPECT_THROW(corrupt(firstOption + offsetof(_detail::SerializedOption, valueCount), header.valueCount + 1), _detail::SerializationError);
+    EXPECT_THROW(corrupt(firstAlias + offsetof(_detail::SerializedAlias, option), header.optionCount), _detail::SerializationError);
+    EXPECT_THROW(corrupt(header.values, 0xFFFFFFFFu), _detail::SerializationError);
+    EXPECT_THROW(corrupt(header.handles, header.optionCount), _detail::SerializationError);
+    EXPECT_THROW(corrupt(header.size - 4, 0x41414141u), _detail::SerializationError);
+    // Offsets within the buffer are accepted, whatever the string they point to
+    _detail::SerializedOption option;
+    std::memcpy(&option, buffer.data() + firstOption, sizeof(option));
+    EXPECT_NO_THROW(corrupt(firstOption + offsetof(_detail::SerializedOption, key), option.value));
+}
+
+TEST_F(ProgramOptionsTest, serialized_view_conversion_errors_are_written_to_its_output)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-a"}, {"Aoption"} };
+    Cli po{ argc, argv };
+    po.option("-a", "--alpha");
+    po.parse();
+    auto buffer = serialize(po);
+    CliView view(buffer.data(), buffer.size());
+    view.changeIO(&std::cerr);
+
+    EXPECT_EXIT(view.valueAs<int>("-a"), testing::ExitedWithCode(1), "Type of value 'Aoption' is not expected for option -a");
+}
+
+TEST_F(ProgramOptionsTest, serialized_view_attached_in_forked_process)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"-d"}, {"15"}, {"-e"}, {"15.2156"} };
+    Cli po{ argc, argv };
+    po.option("-d", "--delta");
+    po.option("-e", "--echo");
+    po.parse();
+
+    int fd = serializeToMemoryFile(po);
+    EXPECT_EXIT({
+        auto view = CliView::attach(fd);
+        exit(view.valueAs<int>("--delta") == 15 && view.valueAs<double>("-e") == 15.2156 ? 0 : 1);
+    }, testing::ExitedWithCode(0), "");
+    ::close(fd);
+}
+
+TEST_F(ProgramOptionsTest, serialized_view_read_from_pipe)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-a"}, {"Aoption"} };
+    Cli po{ argc, argv };
+    po.option("-a", "--alpha");
+    po.parse();
+
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+    writeSerialized(po, fds[1]);
+    ::close(fds[1]);
+    auto buffer = readSerialized(fds[0]);
+    ::close(fds[0]);
+
+    CliView view(buffer.data(), buffer.size());
+    EXPECT_TRUE(view.exists("--alpha"));
+    EXPECT_STREQ("Aoption", view.value("-a"));
+}
+
+TEST_F(ProgramOptionsTest, option_handles_are_dense_and_index_the_options)
+{
+    int argc = 7;
+    const char* argv[7]{ {"programoptions"}, {"--alpha"}, {"Aoption"}, {"-m"}, {"1"}, {"2"}, {"-f"} };
+    Cli po{ argc, argv };
+    auto a = po.option("-a", "--alpha", "Option A").handle();
+    auto m = po.option("-m", "--multi", "Multi", "", OptionType::MultiValue).handle();
+    ValueOption b(&po, "-b", "--bravo", "Option B", "7");
+    auto f = po.flag("-f", "Flag").handle();
+    auto t = po.tagless().handle();
+    po.parse();
+
+    EXPECT_EQ(a.index + 1, m.index);
+    EXPECT_EQ(m.index + 1, b.handle().index);
+    EXPECT_EQ(b.handle().index + 1, f.index);
+    EXPECT_EQ(f.index + 1, t.index);
+    EXPECT_EQ(a, po.handle("--alpha"));
+    EXPECT_FALSE(OptionHandle().valid());
+    EXPECT_TRUE(std::is_trivially_copyable<OptionHandle>::value);
+    EXPECT_EQ(&po.getOption("-a"), &po.getOption(a));
+    EXPECT_TRUE(po.exists(a));
+    EXPECT_FALSE(po.exists(b.handle()));
+    EXPECT_EQ(7, po.valueAs<int>(b.handle()));
+    EXPECT_EQ(1, po.existsCount(f));
+    EXPECT_FALSE(po.exists(t));
+
+    auto buffer = serialize(po);
+    CliView view(buffer.data(), buffer.size());
+    for (auto handle : { a, m, b.handle(), f, t, po.handle("-h") })
+    {
+        EXPECT_EQ(po.exists(handle), view.exists(handle));
+        EXPECT_EQ(po.existsCount(handle), view.existsCount(handle));
+        EXPECT_STREQ(po.getOption(handle).value(), view.value(handle));
+        EXPECT_EQ(po.getOption(handle).values().size(), view.values(handle).size());
+    }
+    EXPECT_EQ(std::deque<int>({ 1, 2 }), view.valuesAs<int>(m));
+    EXPECT_EQ(7, view.valueAs<int>(b.handle()));
+}
+
+TEST_F(ProgramOptionsTest, typed_options_convert_while_parsing)
+{
+    int argc = 9;
+    const char* argv[9]{ {"programoptions"}, {"-d"}, {"15"}, {"-e"}, {"15.2156"}, {"-m"}, {"1"}, {"2"}, {"3"} };
+    Cli po{ argc, argv };
+    TypedOption<int> d(&po, "-d", "--delta");
+    auto& e = po.typedOption<double>("-e", "--echo");
+    auto& m = po.typedMultiOption<int>("-m", "--multi", "", { 7 });
+    auto& defaulted = po.typedOption<std::string>("-s", "--string", "", "default");
+    auto& defaultedMulti = po.typedMultiOption<int>("-n", "--numbers", "", { 4, 5 });
+    po.parse();
+
+    EXPECT_EQ(15, d.get());
+    EXPECT_EQ(15.2156, e.get());
+    EXPECT_EQ(std::vector<int>({ 1, 2, 3 }), m.get());
+    EXPECT_FALSE(defaulted.exists());
+    EXPECT_EQ("default", defaulted.get());
+    EXPECT_EQ(std::vector<int>({ 4, 5 }), defaultedMulti.get());
+}
+
+TEST_F(ProgramOptionsTest, typed_option_conversion_error_exits_while_parsing)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-d"}, {"abc"} };
+    Cli po{ argc, argv };
+    po.typedOption<int>("-d", "--delta");
+
+    EXPECT_EXIT(po.parse(), testing::ExitedWithCode(1), "");
+}
+
+TEST_F(ProgramOptionsTest, typed_multi_option_conversion_error_exits_while_parsing)
+{
+    int argc = 4;
+    const char* argv[4]{ {"programoptions"}, {"-m"}, {"1"}, {"x2.5"} };
+    Cli po{ argc, argv };
+    po.typedMultiOption<double>("-m", "--multi");
+
+    EXPECT_EXIT(po.parse(), testing::ExitedWithCode(1), "");
+}
+
+TEST_F(ProgramOptionsTest, numbers_are_converted_with_prefixes_separators_and_units)
+{
+    EXPECT_EQ(std::make_pair(0xff00, false), _detail::valueAs<int>("0xff00"));
+    EXPECT_EQ(std::make_pair(0755, false), _detail::valueAs<int>("0o755"));
+    EXPECT_EQ(std::make_pair(0xA5, false), _detail::valueAs<int>("0b1010'0101"));
+    EXPECT_EQ(std::make_pair(1000000, false), _detail::valueAs<int>("1_000_000"));
+    EXPECT_EQ(std::make_pair(-1500, false), _detail::valueAs<int>("-1.5k"));
+    EXPECT_EQ(std::make_pair(65536ull, false), _detail::valueAs<unsigned long long>("64Ki"));
+    EXPECT_EQ(std::make_pair(-128, false), _detail::valueAs<int>("-128"));
+    EXPECT_EQ(std::make_pair(1500.0, false), _detail::valueAs<double>("1.5k"));
+    EXPECT_EQ(std::make_pair(0.001, false), _detail::valueAs<double>("1e-3"));
+    EXPECT_EQ(std::make_pair(std::numeric_limits<std::int16_t>::min(), false), _detail::valueAs<std::int16_t>("-0x8000"));
+    for (const char* invalid : { "", "0x", "1.5", "1__0", "_1", "1k5", "0xffk", "1.5Ki1", "2147483648", "-2147483649", "5G", "12abc" })
+        EXPECT_TRUE(_detail::valueAs<int>(invalid).second) << invalid;
+    EXPECT_TRUE(_detail::valueAs<unsigned>("-1").second);
+    EXPECT_TRUE(_detail::valueAs<unsigned long long>("16Ei").second);
+    EXPECT_TRUE(_detail::valueAs<float>("1E40").second);
+}
+
+TEST_F(ProgramOptionsTest, byte_sizes_and_durations_are_converted_with_units)
+{
+    EXPECT_EQ(std::make_pair(Bytes(512ull << 20), false), _detail::valueAs<Bytes>("512MiB"));
+    EXPECT_EQ(std::make_pair(Bytes(1500000000), false), _detail::valueAs<Bytes>("1.5GB"));
+    EXPECT_EQ(std::make_pair(Bytes(4096), false), _detail::valueAs<Bytes>("0x1000"));
+    EXPECT_EQ(std::make_pair(Bytes(0), false), _detail::valueAs<Bytes>("0B"));
+    EXPECT_EQ(std::make_pair(Bytes(2048), false), _detail::valueAs<Bytes>("2 KiB"));
+    EXPECT_EQ(std::make_pair(std::chrono::milliseconds(250), false), _detail::valueAs<std::chrono::milliseconds>("250ms"));
+    EXPECT_EQ(std::make_pair(std::chrono::milliseconds(1500), false), _detail::valueAs<std::chrono::milliseconds>("1.5s"));
+    EXPECT_EQ(std::make_pair(std::chrono::milliseconds(40), false), _detail::valueAs<std::chrono::milliseconds>("40"));
+    EXPECT_EQ(std::make_pair(std::chrono::seconds(7200), false), _detail::valueAs<std::chrono::seconds>("2h"));
+    EXPECT_EQ(std::make_pair(std::chrono::nanoseconds(1000), false), _detail::valueAs<std::chrono::nanoseconds>("1us"));
+    EXPECT_EQ(std::make_pair(std::chrono::duration<double>(0.25), false), _detail::valueAs<std::chrono::duration<double>>("250ms"));
+    for (const char* invalid : { "-1KiB", "0.3KiB", "1.5B", "16EiB", "1XB" })
+        EXPECT_TRUE(_detail::valueAs<Bytes>(invalid).second) << invalid;
+    for (const char* invalid : { "1500us", "1m", "ms", "1e3s" })
+        EXPECT_TRUE(_detail::valueAs<std::chrono::milliseconds>(invalid).second) << invalid;
+    EXPECT_EQ("512MiB", _detail::toString(Bytes(512ull << 20)));
+    EXPECT_EQ("250ms", _detail::toString(std::chrono::milliseconds(250)));
+}
+
+TEST_F(ProgramOptionsTest, min_max_constraint_limits_are_written_in_units)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"--cache"}, {"512MiB"}, {"--timeout"}, {"250ms"} };
+    Cli po{ argc, argv };
+    TypedOption<Bytes> cache(&po, "--cache");
+    TypedOption<std::chrono::milliseconds> timeout(&po, "--timeout");
+    cache.constrain<Bytes>("1MiB", "1GiB");
+    timeout.constrain<std::chrono::milliseconds>("10ms", "1s");
+    po.parse();
+
+    EXPECT_EQ(Bytes(512ull << 20), cache.get());
+    EXPECT_EQ(std::chrono::milliseconds(250), timeout.get());
+    EXPECT_THROW(cache.constrain<Bytes>("1MiB", "lots"), _detail::InvalidConstraintLimit);
+
+    const char* large[3]{ {"programoptions"}, {"--cache"}, {"2GiB"} };
+    std::stringstream output;
+    Cli limited{ 3, large };
+    limited.changeIO(&output);
+    limited.option("--cache").constrain<Bytes>("1MiB", "1GiB");
+    auto result = limited.tryParse();
+    ASSERT_EQ(1u, result.diagnostics().size());
+    EXPECT_EQ(Diagnostic::Kind::ConstraintViolation, result.diagnostics()[0].kind);
+    EXPECT_NE(std::string::npos, result.diagnostics()[0].message().find("between 1MiB, 1GiB"));
+}
+
+TEST_F(ProgramOptionsTest, range_option_parses_intervals)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"--shards"}, {"0-4095,8192-12287:4"}, {"--shards"}, {"4096-4100,5000"} };
+    Cli po{ argc, argv };
+    RangeOption shards(&po, "--shards");
+    po.parse();
+
+    ASSERT_EQ(3, shards.intervals().size());
+    EXPECT_EQ(4101 + 1 + 1024, shards.count());
+    EXPECT_TRUE(shards.contains(0));
+    EXPECT_TRUE(shards.contains(4100));
+    EXPECT_FALSE(shards.contains(4101));
+    EXPECT_TRUE(shards.contains(5000));
+    EXPECT_TRUE(shards.contains(8196));
+    EXPECT_FALSE(shards.contains(8197));
+    EXPECT_TRUE(shards.contains(12284));
+    EXPECT_FALSE(shards.contains(12288));
+}
+
+TEST_F(ProgramOptionsTest, range_option_iterates_lazily)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"--cpus"}, {"7,0-2,10-20:5,3"} };
+    Cli po{ argc, argv };
+    RangeOption cpus(&po, "--cpus", "", "", "0-127");
+    po.parse();
+
+    EXPECT_EQ(std::vector<std::uint64_t>({ 0, 1, 2, 3, 7, 10, 15, 20 }), std::vector<std::uint64_t>(cpus.begin(), cpus.end()));
+}
+
+TEST_F(ProgramOptionsTest, range_option_large_sets_stay_compact)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"--ids"}, {"0-999999999,2000000000-2999999999:2"} };
+    Cli po{ argc, argv };
+    RangeOption ids(&po, "--ids", "", "", "1-2");
+    EXPECT_TRUE(ids.contains(2));
+    po.parse();
+
+    EXPECT_EQ(2, ids.intervals().size());
+    EXPECT_EQ(1500000000, ids.count());
+    EXPECT_TRUE(ids.contains(2999999998));
+    EXPECT_FALSE(ids.contains(2999999999));
+}
+
+TEST_F(ProgramOptionsTest, range_option_merges_overlapping_and_duplicate_values)
+{
+    auto values = [](const RangeOption& option) { return std::vector<std::uint64_t>(option.begin(), option.end()); };
+    const struct
+    {
+        const char* range;
+        std::vector<std::uint64_t> expected;
+        size_t intervals;
+    } cases[] = {
+        { "0-10:2,4", { 0, 2, 4, 6, 8, 10 }, 1 },
+        { "0-10:2,5", { 0, 2, 4, 5, 6, 8, 10 }, 3 },
+        { "0-10:2,10-12", { 0, 2, 4, 6, 8, 10, 11, 12 }, 2 },
+        { "0-10:2,4-20:3", { 0, 2, 4, 6, 7, 8, 10, 13, 16, 19 }, 4 },
+        { "0-12:3,0-12:2", { 0, 2, 3, 4, 6, 8, 9, 10, 12 }, 5 },
+        { "1-9:2,0-10:2", { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 }, 1 },
+        { "3-5,0-10,4,7-20:7", { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 14 }, 2 },
+    };
+    for (const auto& test : cases)
+    {
+        int argc = 3;
+        const char* argv[3]{ {"programoptions"}, {"--ids"}, test.range };
+        Cli po{ argc, argv };
+        RangeOption ids(&po, "--ids");
+        auto result = po.tryParse();
+        ASSERT_TRUE(result.ok()) << test.range;
+        EXPECT_EQ(test.expected, values(ids)) << test.range;
+        EXPECT_EQ(test.expected.size(), ids.count()) << test.range;
+        EXPECT_EQ(test.intervals, ids.intervals().size()) << test.range;
+    }
+
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"--cpus"}, {"0-10:2"}, {"--cpus"}, {"3"} };
+    Cli po{ argc, argv };
+    RangeOption cpus(&po, "--cpus", "", "", "0-127");
+    EXPECT_TRUE(po.tryParse().ok());
+    EXPECT_EQ(std::vector<std::uint64_t>({ 0, 2, 3, 4, 6, 8, 10 }), values(cpus));
+}
+
+TEST_F(ProgramOptionsTest, range_option_keeps_values_of_rejected_argument_out)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"--cpus"}, {"0-10:2"}, {"--cpus"}, {"12-14,x"} };
+    Cli po{ argc, argv };
+    RangeOption cpus(&po, "--cpus");
+    EXPECT_FALSE(po.tryParse().ok());
+    EXPECT_EQ(6, cpus.count());
+    EXPECT_FALSE(cpus.contains(12));
+}
+
+TEST_F(ProgramOptionsTest, range_option_exits_on_invalid_ranges)
+{
+    for (const char* range : { "5-1", "1-", "a", "1,,2", "0-10:0" })
+    {
+        int argc = 3;
+        const char* argv[3]{ {"programoptions"}, {"--ids"}, range };
+        Cli po{ argc, argv };
+        RangeOption ids(&po, "--ids");
+        EXPECT_EXIT(po.parse(), testing::ExitedWithCode(1), "") << range;
+    }
+    Cli po{ argc, argv };
+    EXPECT_THROW(RangeOption(&po, "--ids", "", "", "x"), _detail::InvalidDefaultValue);
+}
+
+TEST_F(ProgramOptionsTest, file_option_maps_contents)
+{
+    auto path = WriteFile("bazpo_file_option.bin", "model contents");
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-m"}, path.c_str() };
+    Cli po{ argc, argv };
+    FileOption model(&po, "-m", "--model", "Model file");
+    FileOption dictionary(&po, "-d", "--dictionary", "Dictionary file");
+    po.parse();
+
+    ExpectOptionExistsWithValue(model, path);
+    ASSERT_EQ(14, model.size());
+    EXPECT_EQ("model contents", std::string(model.data(), model.size()));
+    EXPECT_EQ(0, dictionary.size());
+    EXPECT_STREQ("", dictionary.data());
+}
+
+TEST_F(ProgramOptionsTest, file_option_exits_when_file_does_not_exist)
+{
+    auto missing = testing::TempDir() + TempName("bazpo_missing_file.bin");
+    auto directory = testing::TempDir();
+    for (const std::string& path : { missing, directory })
+    {
+        int argc = 3;
+        const char* argv[3]{ {"programoptions"}, {"-m"}, path.c_str() };
+        Cli po{ argc, argv };
+        FileOption model(&po, "-m", "--model");
+        EXPECT_EXIT(po.parse(), testing::ExitedWithCode(1), "") << path;
+    }
+}
+
+TEST_F(ProgramOptionsTest, file_option_default_must_exist)
+{
+    auto existing = WriteFile("bazpo_default_file.bin", "defaults");
+    auto missing = testing::TempDir() + TempName("bazpo_missing_default.bin");
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    Cli po{ argc, argv };
+    FileOption model(&po, "-m", "--model", "", existing.c_str());
+    po.parse();
+    EXPECT_EQ("defaults", std::string(model.data(), model.size()));
+
+    EXPECT_THROW(FileOption(&po, "-d", "", "", missing.c_str()), _detail::InvalidDefaultValue);
+    EXPECT_THROW(FileOption(&po, "-t", "", "", testing::TempDir().c_str()), _detail::InvalidDefaultValue);
+}
+
+enum class Compression { None, Fast, Best };
+constexpr auto compressions = enumTable<Compression>({ { "none", Compression::None }, { "fast", Compression::Fast }, { "best", Compression::Best }, { "lz4", Compression::Fast } });
+static_assert(compressions.find("best")->value == Compression::Best, "names are looked up at compile time");
+static_assert(compressions.find("lz4")->value == Compression::Fast, "names may share a value");
+static_assert(compressions.find("bes") == nullptr && compressions.find("") == nullptr, "unknown names are not found");
+
+TEST_F(ProgramOptionsTest, enum_option_stores_value_of_name)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-c"}, {"lz4"} };
+    std::stringstream output;
+    Cli po{ argc, argv };
+    po.changeIO(&output);
+    EnumOption<Compression, 4> compression(&po, compressions, "-c", "--compression", "Compression");
+    EnumOption<Compression, 4> archive(&po, compressions, "-a", "--archive", "", Compression::Best);
+    po.parse();
+
+    EXPECT_EQ(Compression::Fast, compression.get());
+    EXPECT_EQ(Compression::Best, archive.get());
+    EXPECT_STREQ("best", archive.value());
+    po.printOptions();
+    EXPECT_NE(std::string::npos, output.str().find("Compression {none,fast,best,lz4}"));
+    const char* words[2]{ {"-c"}, {""} };
+    EXPECT_EQ("none\nfast\nbest\nlz4\n", po.completions(2, words));
+    for (const char* name : { "none", "fast", "best", "lz4" })
+        EXPECT_STREQ(name, compressions.find(name)->name);
+}
+
+TEST_F(ProgramOptionsTest, enum_option_rejects_unknown_names)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-c"}, {"Fast"} };
+    std::stringstream output;
+    Cli po{ argc, argv };
+    po.changeIO(&output);
+    EnumOption<Compression, 4> compression(&po, compressions, "-c");
+
+    auto result = po.tryParse();
+    ASSERT_EQ(1u, result.diagnostics().size());
+    EXPECT_EQ(Diagnostic::Kind::InvalidValue, result.diagnostics()[0].kind);
+    EXPECT_EQ(Compression::None, compression.get());
+    EXPECT_THROW(enumTable<Compression>({ { "fast", Compression::Fast }, { "fast", Compression::Best } }), _detail::InvalidEnumTable);
+}
+
+TEST_F(ProgramOptionsTest, map_option_splits_definitions_into_views_of_the_arguments)
+{
+    int argc = 9;
+    const char* argv[9]{ {"programoptions"}, {"-D"}, {"threads=4"}, {"-D"}, {"mode=fast"}, {"-Ddebug"}, {"-D"}, {"threads=8"}, {"--undef=x=1"} };
+    Cli po{ argc, argv };
+    MapOption last(&po, "-D", "--define", "Definitions");
+    MapOption undefined(&po, "--undef");
+    po.parse();
+    Cli firstWins{ argc, argv };
+    MapOption first(&firstWins, "-D", "--define", "", MapPolicy::FirstWins);
+    firstWins.unexpectedArgumentsAcceptable();
+    firstWins.parse();
+
+    ASSERT_EQ(3u, last.size());
+    EXPECT_STREQ("8", last.find("threads"));
+    EXPECT_EQ(argv[7] + 8, last.find("threads"));
+    EXPECT_EQ(4, first.valueAt<int>("threads"));
+    EXPECT_STREQ("fast", last.find(std::string("mode")));
+    EXPECT_STREQ("", last.find("debug"));
+    EXPECT_EQ(nullptr, last.find("thread"));
+    EXPECT_FALSE(last.contains("missing"));
+    EXPECT_EQ(2, last.valueAt<int>("missing", 2));
+    EXPECT_EQ("threads=8", last.valueAs<std::string>());
+    EXPECT_EQ(4u, last.valuesAs<std::string>().size());
+    EXPECT_STREQ("x=1", undefined.values()[0]);
+    EXPECT_STREQ("1", undefined.find("x"));
+    // First given order
+    std::vector<std::string> keys;
+    for (const auto& entry : last)
+        keys.push_back(entry.name());
+    EXPECT_EQ((std::vector<std::string>{ "threads", "mode", "debug" }), keys);
+}
+
+TEST_F(ProgramOptionsTest, map_option_rejects_empty_keys_and_indexes_many_definitions)
+{
+    std::vector<std::string> definitions;
+    for (int i = 0; i < 3000; ++i)
+        definitions.push_back("key" + std::to_string(i) + "=" + std::to_string(i));
+    std::vector<const char*> argv{ "programoptions" };
+    for (const auto& definition : definitions)
+    {
+        argv.push_back("-D");
+        argv.push_back(definition.c_str());
+    }
+    Cli po{ static_cast<int>(argv.size()), argv.data() };
+    MapOption defines(&po, "-D");
+    po.parse();
+
+    ASSERT_EQ(3000u, defines.size());
+    for (int i = 0; i < 3000; ++i)
+        EXPECT_EQ(i, defines.valueAt<int>("key" + std::to_string(i), -1));
+
+    const char* invalid[3]{ {"programoptions"}, {"-D"}, {"=1"} };
+    Cli failing{ 3, invalid };
+    MapOption failingDefines(&failing, "-D");
+    auto result = failing.tryParse();
+    ASSERT_EQ(1u, result.diagnostics().size());
+    EXPECT_EQ(Diagnostic::Kind::InvalidValue, result.diagnostics()[0].kind);
+}
+
+TEST_F(ProgramOptionsTest, try_parse_reports_all_errors_without_exiting)
+{
+    int argc = 7;
+    const char* argv[7]{ {"programoptions"}, {"-a"}, {"x"}, {"-c"}, {"blue"}, {"unexpected"}, {"-f"} };
+    std::stringstream output;
+    bool executed = false;
+    Cli po{ argc, argv };
+    po.changeIO(&output);
+    po.typedOption<int>("-a");
+    po.option("-b").mandatory();
+    po.option("-c").constrain({ "red", "green" });
+    po.flag("-f", [&](const Option&) { executed = true; });
+
+    auto result = po.tryParse();
+    ASSERT_FALSE(result.ok());
+    ASSERT_EQ(4u, result.diagnostics().size());
+    EXPECT_EQ(Diagnostic::Kind::InvalidValue, result.diagnostics()[0].kind);
+    EXPECT_EQ(2, result.diagnostics()[0].argIndex);
+    EXPECT_STREQ("x", result.diagnostics()[0].value);
+    EXPECT_EQ(Diagnostic::Kind::ConstraintViolation, result.diagnostics()[1].kind);
+    EXPECT_EQ(4, result.diagnostics()[1].argIndex);
+    EXPECT_EQ(&po.getOption("-c"), result.diagnostics()[1].option);
+    EXPECT_EQ(Diagnostic::Kind::UnexpectedArgument, result.diagnostics()[2].kind);
+    EXPECT_EQ(5, result.diagnostics()[2].argIndex);
+    EXPECT_EQ(Diagnostic::Kind::MissingMandatory, result.diagnostics()[3].kind);
+    EXPECT_EQ(-1, result.diagnostics()[3].argIndex);
+    EXPECT_EQ("Type of value 'x' is not expected for option -a", result.diagnostics()[0].message());
+    EXPECT_EQ("-b is a required parameter", result.diagnostics()[3].message());
+    EXPECT_FALSE(executed);
+    EXPECT_TRUE(output.str().empty());
+
+    // Values converted by the functions after parsing
+    int functionArgc = 6;
+    const char* functionArgv[6]{ {"programoptions"}, {"-n"}, {"y"}, {"-m"}, {"3"}, {"z"} };
+    int converted = 0;
+    Cli functions{ functionArgc, functionArgv };
+    functions.changeIO(&output);
+    functions.option("-n", [&](const Option& option) { converted += option.valueAs<int>(); });
+    functions.option("-m", [&](const Option& option) { for (int value : option.valuesAs<int>()) converted += value; }, "", "", "", OptionType::MultiValue);
+
+    result = functions.tryParse();
+    ASSERT_EQ(2u, result.diagnostics().size());
+    EXPECT_EQ(Diagnostic::Kind::InvalidValue, result.diagnostics()[0].kind);
+    EXPECT_EQ(2, result.diagnostics()[0].argIndex);
+    EXPECT_EQ(&functions.getOption("-n"), result.diagnostics()[0].option);
+    EXPECT_EQ("Type of value 'y' is not expected for option -n", result.diagnostics()[0].message());
+    EXPECT_EQ(Diagnostic::Kind::InvalidValue, result.diagnostics()[1].kind);
+    EXPECT_EQ(5, result.diagnostics()[1].argIndex);
+    EXPECT_STREQ("z", result.diagnostics()[1].value);
+    EXPECT_EQ(3, converted);
+    EXPECT_FALSE(result.helpRequested());
+    EXPECT_TRUE(output.str().empty());
+}
+
+TEST_F(ProgramOptionsTest, try_parse_executes_functions_when_successful)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-a"}, {"1"} };
+    bool executed = false;
+    Cli po{ argc, argv };
+    po.option("-a", [&](const Option&) { executed = true; });
+
+    auto result = po.tryParse();
+    EXPECT_TRUE(result);
+    EXPECT_TRUE(result.message().empty());
+    EXPECT_FALSE(result.helpRequested());
+    EXPECT_TRUE(executed);
+}
+
+TEST_F(ProgramOptionsTest, try_parse_prints_help_without_exiting)
+{
+    int argc = 2;
+    const char* argv[2]{ {"programoptions"}, {"-h"} };
+    std::stringstream output;
+    Cli po{ argc, argv };
+    po.changeIO(&output);
+
+    auto result = po.tryParse();
+    EXPECT_TRUE(result.ok());
+    EXPECT_TRUE(result.helpRequested());
+    EXPECT_NE(std::string::npos, output.str().find("Prints this help message"));
+}
+
+TEST_F(ProgramOptionsTest, try_parse_reports_subcommand_errors_with_argument_index)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"-v"}, {"build"}, {"-j"}, {"many"} };
+    bool executed = false;
+    Cli po{ argc, argv };
+    po.flag("-v", [&](const Option&) { executed = true; });
+    po.subcommand("build", [](Cli& build) { build.typedOption<int>("-j"); });
+
+    auto result = po.tryParse();
+    ASSERT_EQ(1u, result.diagnostics().size());
+    EXPECT_EQ(4, result.diagnostics()[0].argIndex);
+    EXPECT_EQ("Type of value 'many' is not expected for option -j\n", result.message());
+    EXPECT_FALSE(executed);
+}
+
+TEST_F(ProgramOptionsTest, inline_values_and_combined_flags_are_split)
+{
+    int argc = 8;
+    const char* argv[8]{ {"programoptions"}, {"--threads=8"}, {"-j4"}, {"-xvf"}, {"archive.tar"}, {"--include=a"}, {"b"}, {"-n"} };
+    Cli po{ argc, argv };
+    po.option("--threads", "-t");
+    po.option("-j");
+    po.flag("-x");
+    po.flag("--verbose", "", "-v");
+    po.option("-f");
+    po.option("--include", "", "", "", OptionType::MultiValue);
+    po.option("-n");
+
+    po.parse();
+    ExpectOptionExistsWithValue(po, "-t", "8");
+    ExpectOptionExistsWithValue(po, "-j", "4");
+    EXPECT_TRUE(po.exists("-x"));
+    EXPECT_TRUE(po.exists("--verbose"));
+    ExpectOptionExistsWithValue(po, "-f", "archive.tar");
+    ExpectOptionExistsWithValues(po, "--include", { "a", "b" });
+    // Values refer to the arguments
+    EXPECT_EQ(argv[1] + 10, po.getOption("--threads").value());
+    EXPECT_EQ(argv[2] + 2, po.getOption("-j").value());
+}
+
+TEST_F(ProgramOptionsTest, combined_flags_with_inline_value_and_negative_values)
+{
+    int argc = 4;
+    const char* argv[4]{ {"programoptions"}, {"-xfout.txt"}, {"-n"}, {"-5"} };
+    Cli po{ argc, argv };
+    po.flag("-x");
+    po.option("-f");
+    po.option("-n");
+
+    po.parse();
+    EXPECT_TRUE(po.exists("-x"));
+    ExpectOptionExistsWithValue(po, "-f", "out.txt");
+    EXPECT_EQ(-5, po.valueAs<int>("-n"));
+}
+
+TEST_F(ProgramOptionsTest, program_exits_when_combined_flags_contain_unknown_option)
+{
+    int argc = 2;
+    const char* argv[2]{ {"programoptions"}, {"-xq"} };
+    Cli po{ argc, argv };
+    po.flag("-x");
+
+    EXPECT_EXIT(po.parse(), testing::ExitedWithCode(1), "");
+}
+
+TEST_F(ProgramOptionsTest, prioritized_option_in_combined_flags)
+{
+    int argc = 2;
+    const char* argv[2]{ {"programoptions"}, {"-xh"} };
+    Cli po{ argc, argv };
+    po.flag("-x");
+
+    EXPECT_EXIT(po.parse(), testing::ExitedWithCode(0), "");
+}
+
+TEST_F(ProgramOptionsTest, unique_prefixes_of_long_options_are_accepted)
+{
+    int argc = 6;
+    const char* argv[6]{ {"programoptions"}, {"--verb"}, {"--thr=8"}, {"--out"}, {"result.txt"}, {"--col"} };
+    Cli po{ argc, argv };
+    po.flag("--verbose");
+    po.flag("--version");
+    po.option("--threads", "-t");
+    po.option("--output", "-o");
+    po.flag("--color", "", "--colour");
+    po.abbreviationsAcceptable();
+
+    po.parse();
+    EXPECT_TRUE(po.exists("--verbose"));
+    EXPECT_FALSE(po.exists("--version"));
+    ExpectOptionExistsWithValue(po, "--threads", "8");
+    ExpectOptionExistsWithValue(po, "--output", "result.txt");
+    // Prefix of a name and its alias
+    EXPECT_TRUE(po.exists("--color"));
+    EXPECT_EQ(argv[2] + 6, po.getOption("--threads").value());
+}
+
+TEST_F(ProgramOptionsTest, ambiguous_prefixes_list_all_candidates)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"--ver"}, {"--verbose"} };
+    Cli po{ argc, argv };
+    po.flag("--verbose");
+    po.flag("--version");
+    po.flag("--vertical");
+    po.abbreviationsAcceptable();
+
+    auto result = po.tryParse();
+    ASSERT_EQ(1u, result.diagnostics().size());
+    EXPECT_EQ(Diagnostic::Kind::AmbiguousOption, result.diagnostics()[0].kind);
+    EXPECT_EQ(1, result.diagnostics()[0].argIndex);
+    EXPECT_EQ("Option '--ver' is ambiguous, possible options: --verbose --version --vertical", result.diagnostics()[0].message());
+    EXPECT_TRUE(po.exists("--verbose"));
+
+    Cli exiting{ argc, argv };
+    exiting.flag("--verbose");
+    exiting.flag("--version");
+    exiting.abbreviationsAcceptable();
+    EXPECT_EXIT(exiting.parse(), testing::ExitedWithCode(1), "");
+}
+
+TEST_F(ProgramOptionsTest, prefixes_are_not_accepted_by_default)
+{
+    int argc = 2;
+    const char* argv[2]{ {"programoptions"}, {"--verb"} };
+    Cli po{ argc, argv };
+    po.flag("--verbose");
+
+    EXPECT_EXIT(po.parse(), testing::ExitedWithCode(1), "");
+}
+
+TEST_F(ProgramOptionsTest, static_strings_are_referred_without_copies)
+{
+    static const char defaultThreads[] = "4";
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-t"}, {"8"} };
+    Cli po{ argc, argv };
+    auto& threads = po.option("--threads"_po, "-t"_po, "Thread count"_po, StaticString(defaultThreads, 1));
+    auto& jobs = po.option("--jobs"_po, "-j"_po, "Job count"_po, StaticString(defaultThreads, 1));
+
+    EXPECT_EQ(defaultThreads, jobs.value());
+    po.parse();
+    EXPECT_EQ(8, threads.valueAs<int>());
+    EXPECT_EQ(4, po.valueAs<int>("-j"));
+}
+
+TEST_F(ProgramOptionsTest, dynamic_strings_are_interned)
+{
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    Cli po{ argc, argv };
+    for (int i = 0; i < 2000; ++i)
+        po.option("--option" + std::to_string(i), "-o" + std::to_string(i), "Description " + std::to_string(i % 10), std::to_string(i % 2));
+
+    po.parse();
+    EXPECT_STREQ("1", po.getOption("--option1999").value());
+    EXPECT_EQ(po.getOption("-o1").value(), po.getOption("--option3").value());
+    EXPECT_NE(po.getOption("-o0").value(), po.getOption("--option3").value());
+}
+
+TEST_F(ProgramOptionsTest, descriptions_are_decompressed_when_printed)
+{
+    // Each byte is stored inverted
+    static int decompressed = 0;
+    static const char compressed[]{ static_cast<char>(~'T'), static_cast<char>(~'h'), static_cast<char>(~'r'), static_cast<char>(~'e'), static_cast<char>(~'a'), static_cast<char>(~'d'), static_cast<char>(~'s'), static_cast<char>(~'\0'),
+                                    static_cast<char>(~'I'), static_cast<char>(~'n'), static_cast<char>(~'p'), static_cast<char>(~'u'), static_cast<char>(~'t'), static_cast<char>(~'s') };
+    DescriptionTable descriptions(compressed, sizeof(compressed), [](const char* data, size_t size) {
+        ++decompressed;
+        std::string text(data, size);
+        for (auto& c : text)
+            c = static_cast<char>(~c);
+        return text;
+    });
+    DescriptionTable plain("Output file\0", sizeof("Output file\0") - 1);
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-t"}, {"x"} };
+    std::stringstream output;
+    Cli po{ argc, argv };
+    po.changeIO(&output);
+    po.typedOption<int>("-t", "--threads").describedBy(descriptions, 0);
+    po.tagless().describedBy(descriptions, 1).mandatory();
+    po.option("-o").describedBy(plain, 0);
+
+    auto result = po.tryParse();
+    EXPECT_EQ(0, decompressed);
+    EXPECT_FALSE(descriptions.loaded());
+    ASSERT_EQ(2u, result.diagnostics().size());
+    EXPECT_EQ("Inputs is a required parameter", result.diagnostics()[1].message());
+    EXPECT_EQ(1, decompressed);
+    po.printOptions();
+    EXPECT_EQ(1, decompressed);
+    EXPECT_NE(std::string::npos, output.str().find(" Threads\n"));
+    EXPECT_NE(std::string::npos, output.str().find("Output file\n"));
+    EXPECT_EQ(2u, descriptions.size());
+    EXPECT_EQ("", descriptions[2].str());
+}
+
+TEST_F(ProgramOptionsTest, function_options_keep_move_only_callables)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"-a"}, {"-b"}, {"2"}, {"tagless"} };
+    std::vector<std::string> calls;
+    Cli po{ argc, argv };
+    auto state = std::unique_ptr<int>(new int(41));
+    po.flag("-a", [&calls, state = std::move(state)](const Option&) mutable { calls.push_back("a" + std::to_string(++*state)); });
+    po.option("-b", [&calls](const Option& option) { calls.push_back(std::string("b") + option.value()); });
+    po.tagless([&calls](const Option& option) { calls.push_back(option.value()); });
+
+    po.parse();
+    EXPECT_EQ((std::vector<std::string>{ "a42", "b2", "tagless" }), calls);
+}
+
+TEST_F(ProgramOptionsTest, function_option_destroys_stored_callable)
+{
+    int argc = 2;
+    const char* argv[2]{ {"programoptions"}, {"-a"} };
+    auto shared = std::make_shared<int>(0);
+    {
+        Cli po{ argc, argv };
+        FunctionFlag flag(&po, "-a", [shared](const Option&) { ++*shared; });
+        std::function<void(const Option&)> function = [shared](const Option&) { ++*shared; };
+        FunctionOption option(&po, "-b", function);
+        EXPECT_EQ(4, shared.use_count());
+        po.parse();
+    }
+    EXPECT_EQ(1, *shared);
+    EXPECT_EQ(1, shared.use_count());
+}
+
+TEST_F(ProgramOptionsTest, function_options_allocate_large_callables)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-a"}, {"-b"} };
+    auto shared = std::make_shared<int>(0);
+    char large[256] = "large";
+    {
+        Cli po{ argc, argv };
+        FunctionFlag flag(&po, "-a", [shared, large](const Option&) { *shared += large[0] == 'l' ? 1 : 0; });
+        po.flag("-b", [shared, large](const Option&) { *shared += large[1] == 'a' ? 10 : 0; });
+        EXPECT_EQ(3, shared.use_count());
+        po.parse();
+    }
+    EXPECT_EQ(11, *shared);
+    EXPECT_EQ(1, shared.use_count());
+}
+
+TEST_F(ProgramOptionsTest, function_options_executed_after_dependencies)
+{
+    int argc = 4;
+    const char* argv[4]{ {"programoptions"}, {"-a"}, {"-b"}, {"-c"} };
+    std::string order;
+    Cli po{ argc, argv };
+    po.flag("-a", [&](const Option&) { order += "a"; }, "", "--alpha").dependsOn("-c");
+    po.flag("-b", [&](const Option&) { order += "b"; }).dependsOn("--alpha");
+    po.flag("-c", [&](const Option&) { order += "c"; });
+    po.flag("-d", [&](const Option&) { order += "d"; });
+    po.dependency("-c", "-d");
+    po.parse();
+
+    EXPECT_EQ("cab", order);
+}
+
+TEST_F(ProgramOptionsTest, parallel_executor_runs_independent_functions_concurrently)
+{
+    int argc = 4;
+    const char* argv[4]{ {"programoptions"}, {"-a"}, {"-b"}, {"-c"} };
+    std::atomic<int> arrived{ 0 };
+    std::atomic<bool> dependencyDone{ false };
+    bool concurrent = true;
+    bool orderedAfterDependencies = false;
+    auto meet = [&](const Option&) {
+        ++arrived;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (arrived < 2 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::yield();
+        concurrent = concurrent && arrived >= 2;
+        dependencyDone = true;
+    };
+    Cli po{ argc, argv };
+    po.callbackExecutor(std::make_shared<ParallelExecutor>(4));
+    po.flag("-a", meet);
+    po.flag("-b", meet);
+    po.flag("-c", [&](const Option&) { orderedAfterDependencies = dependencyDone; }).dependsOn("-a").dependsOn("-b");
+    po.parse();
+
+    EXPECT_TRUE(concurrent);
+    EXPECT_TRUE(orderedAfterDependencies);
+}
+
+TEST_F(ProgramOptionsTest, parallel_executor_rethrows_first_failure_in_key_order)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"-a"}, {"-b"}, {"-c"}, {"-d"} };
+    std::atomic<bool> dependentExecuted{ false };
+    std::atomic<bool> independentExecuted{ false };
+    Cli po{ argc, argv };
+    po.callbackExecutor(std::make_shared<ParallelExecutor>(3));
+    po.flag("-a", [&](const Option&) { std::this_thread::sleep_for(std::chrono::milliseconds(20)); throw std::runtime_error("a"); });
+    po.flag("-b", [&](const Option&) { throw std::runtime_error("b"); });
+    po.flag("-c", [&](const Option&) { dependentExecuted = true; }).dependsOn("-b");
+    po.flag("-d", [&](const Option&) { independentExecuted = true; });
+
+    try
+    {
+        po.parse();
+        FAIL() << "exception expected";
+    }
+    catch (const std::runtime_error& error)
+    {
+        EXPECT_STREQ("a", error.what());
+    }
+    EXPECT_FALSE(dependentExecuted);
+    EXPECT_TRUE(independentExecuted);
+}
+
+TEST_F(ProgramOptionsTest, function_option_dependency_cycle_throws)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-a"}, {"-b"} };
+    bool executed = false;
+    for (auto executor : { std::shared_ptr<CallbackExecutor>(), std::shared_ptr<CallbackExecutor>(std::make_shared<ParallelExecutor>(2)) })
+    {
+        Cli po{ argc, argv };
+        po.callbackExecutor(executor);
+        po.flag("-a", [&](const Option&) { executed = true; }).dependsOn("-b");
+        po.flag("-b", [&](const Option&) { executed = true; }).dependsOn("-a");
+
+        EXPECT_THROW(po.parse(), _detail::CallbackDependencyCycle);
+        EXPECT_FALSE(executed);
+    }
+}
+
+TEST_F(ProgramOptionsTest, function_option_unknown_dependency_throws)
+{
+    int argc = 2;
+    const char* argv[2]{ {"programoptions"}, {"-a"} };
+    bool executed = false;
+    Cli po{ argc, argv };
+    po.flag("-a", [&](const Option&) { executed = true; }).dependsOn("-missing");
+
+    try
+    {
+        po.parse();
+        FAIL() << "exception expected";
+    }
+    catch (const std::exception& error)
+    {
+        EXPECT_NE(nullptr, std::strstr(error.what(), "-missing"));
+    }
+    EXPECT_FALSE(executed);
+}
+
+TEST_F(ProgramOptionsTest, parallel_executor_is_reused_across_parses)
+{
+    int argc = 4;
+    const char* argv[4]{ {"programoptions"}, {"-a"}, {"-b"}, {"-c"} };
+    auto executor = std::make_shared<ParallelExecutor>(3);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    for (int parse = 0; parse < 20; ++parse)
+    {
+        std::atomic<int> executed{ 0 };
+        auto record = [&](const Option&) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }
+            ++executed;
+        };
+        Cli po{ argc, argv };
+        po.callbackExecutor(executor);
+        po.flag("-a", record);
+        po.flag("-b", record);
+        po.flag("-c", record).dependsOn("-a");
+        po.parse();
+        EXPECT_EQ(3, executed);
+    }
+    // The calling thread and at most the two workers of the executor
+    EXPECT_LE(threads.size(), 3u);
+}
+
+#ifdef BazPO_HAS_COROUTINES
+TEST_F(ProgramOptionsTest, async_functions_overlap_waits_on_pipes)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-a"}, {"-b"} };
+    int request[2];
+    int response[2];
+    ASSERT_EQ(0, ::pipe(request));
+    ASSERT_EQ(0, ::pipe(response));
+    std::string trace;
+    EventLoop loop;
+    Cli po{ argc, argv };
+    // -a waits for the request written by -b, blocking functions would never finish
+    AsyncFunctionFlag server(&po, loop, "-a", [&](const Option&) -> Task {
+        trace += "a-wait ";
+        co_await loop.readable(request[0]);
+        char c;
+        EXPECT_EQ(1, ::read(request[0], &c, 1));
+        trace += "a-read ";
+        EXPECT_EQ(1, ::write(response[1], &c, 1));
+    });
+    AsyncFunctionFlag client(&po, loop, "-b", [&](const Option&) -> Task {
+        EXPECT_EQ(1, ::write(request[1], "x", 1));
+        trace += "b-wait ";
+        co_await loop.readable(response[0]);
+        char c;
+        EXPECT_EQ(1, ::read(response[0], &c, 1));
+        trace += std::string("b-read-") + c;
+    });
+
+    parseAsync(po, loop);
+    EXPECT_EQ("a-wait b-wait a-read b-read-x", trace);
+    for (int fd : { request[0], request[1], response[0], response[1] })
+        ::close(fd);
+}
+
+TEST_F(ProgramOptionsTest, async_functions_sleep_concurrently_and_rethrow)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"-a"}, {"1"}, {"-b"}, {"2"} };
+    EventLoop loop;
+    Cli po{ argc, argv };
+    int finished = 0;
+    auto sleeper = [&](const Option& option) -> Task {
+        co_await loop.sleepFor(std::chrono::milliseconds(200));
+        ++finished;
+        if (option.value() == std::string("2"))
+            throw std::runtime_error("failed");
+    };
+    AsyncFunctionOption a(&po, loop, "-a", sleeper);
+    AsyncFunctionOption b(&po, loop, "-b", sleeper);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_THROW(parseAsync(po, loop), std::runtime_error);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(2, finished);
+    EXPECT_GE(elapsed, std::chrono::milliseconds(200));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(390));
+}
+
+TEST_F(ProgramOptionsTest, async_functions_started_by_parallel_executor_all_finish)
+{
+    int argc = 17;
+    const char* argv[17]{ {"programoptions"} };
+    std::deque<std::string> keys;
+    for (int i = 1; i < argc; ++i)
+    {
+        keys.emplace_back("--flag" + std::to_string(i));
+        argv[i] = keys.back().c_str();
+    }
+    EventLoop loop;
+    Cli po{ argc, argv };
+    po.callbackExecutor(std::make_shared<ParallelExecutor>(4));
+    std::atomic<int> finished{ 0 };
+    std::deque<AsyncFunctionFlag> flags;
+    for (const auto& key : keys)
+        flags.emplace_back(&po, loop, key.c_str(), [&](const Option&) -> Task {
+            co_await loop.sleepFor(std::chrono::milliseconds(1));
+            ++finished;
+        });
+
+    parseAsync(po, loop);
+    EXPECT_EQ(argc - 1, finished.load());
+}
+#else
+TEST_F(ProgramOptionsTest, async_functions_block_without_coroutines)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-a"}, {"-b"} };
+    int channel[2];
+    ASSERT_EQ(0, ::pipe(channel));
+    std::string trace;
+    EventLoop loop;
+    Cli po{ argc, argv };
+    AsyncFunctionFlag writer(&po, loop, "-a", [&](const Option&) {
+        EXPECT_EQ(1, ::write(channel[1], "x", 1));
+        trace += "a ";
+    });
+    AsyncFunctionFlag reader(&po, loop, "-b", [&](const Option&) {
+        loop.readable(channel[0]).wait();
+        char c;
+        EXPECT_EQ(1, ::read(channel[0], &c, 1));
+        trace += std::string("b-") + c;
+    });
+
+    parseAsync(po, loop);
+    EXPECT_EQ("a b-x", trace);
+    ::close(channel[0]);
+    ::close(channel[1]);
+}
+#endif
+
+TEST_F(ProgramOptionsTest, write_function_receives_the_same_text_as_the_stream)
+{
+    Cli po{ argc, argv, "Program Description" };
+    po.option("-a", "--alpha", "Option A");
+    po.flag("-c", "Flag C");
+    po.tagless(2, "FILES");
+    po.subcommand("run", [](Cli& cli) { cli.flag("-f"); }, "Runs the program");
+    std::stringstream stream;
+    po.changeIO(&stream);
+    po.printOptions();
+
+    std::string written;
+    po.output([](void* context, const char* data, size_t size) { static_cast<std::string*>(context)->append(data, size); }, &written);
+    po.printOptions();
+
+    EXPECT_EQ(stream.str(), written);
+    EXPECT_NE(std::string::npos, written.find("Program Options: \n"));
+}
+
+TEST_F(ProgramOptionsTest, read_line_function_answers_asked_input)
+{
+    int argc = 1;
+    const char* argv[] = { "programoptions" };
+    std::deque<std::string> lines{ "input", "15" };
+    std::string written;
+    Cli po(argc, argv);
+    po.option("-a", "--alpha", "Option A").mandatory();
+    po.option("-b", "--bravo", "Option B").mandatory();
+    po.userInputRequired();
+    po.output([](void* context, const char* data, size_t size) { static_cast<std::string*>(context)->append(data, size); }, &written);
+    po.input([](void* context, std::string& line) {
+        auto& lines = *static_cast<std::deque<std::string>*>(context);
+        if (lines.empty())
+            return false;
+        line = lines.front();
+        lines.pop_front();
+        return true;
+    }, &lines);
+
+    po.parse();
+
+    ExpectOptionExistsWithValue(po, "-a", "input");
+    ExpectOptionExistsWithValue(po, "-b", "15");
+    EXPECT_NE(std::string::npos, written.find("is a required parameter"));
+}
+
+TEST_F(ProgramOptionsTest, reload_publishes_changed_options_to_watchers)
+{
+    auto path = WriteFile("bazpo_reload.conf", "alpha = first\nthreads = 4\n");
+    int argc = 2;
+    const char* argv[2]{ {"programoptions"}, {"-v"} };
+    ReloadableCli options{ argc, argv, [&](Cli& cli) {
+        cli.option("-a", "--alpha");
+        cli.option("--threads");
+        cli.flag("-v");
+        cli.flag("--debug");
+        cli.source(ConfigFile::load(path));
+    } };
+    std::vector<std::string> changed;
+    options.watch([&](const std::vector<std::string>& keys, const CliView& previous, const CliView& current) {
+        changed = keys;
+        EXPECT_STREQ("first", previous.value("-a"));
+        EXPECT_STREQ("second", current.value("-a"));
+    });
+    EXPECT_STREQ("first", options.read()->value("-a"));
+
+    WriteFile("bazpo_reload.conf", "alpha = second\nthreads = 4\ndebug\n");
+    EXPECT_TRUE(options.reload().ok());
+
+    EXPECT_EQ(std::vector<std::string>({ "--debug", "-a" }), changed);
+    auto snapshot = options.read();
+    EXPECT_STREQ("second", snapshot->value("-a"));
+    EXPECT_TRUE(snapshot->exists("--debug"));
+    EXPECT_TRUE(snapshot->exists("-v"));
+}
+
+TEST_F(ProgramOptionsTest, reload_waits_for_readers_of_replaced_snapshot)
+{
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    std::string value = "first";
+    ReloadableCli options{ argc, argv, [&](Cli& cli) { cli.option("-a", "", "", value); } };
+    std::atomic<bool> reloaded{ false };
+    auto before = options.read();
+
+    value = "second";
+    std::thread reloading([&]() {
+        options.reload();
+        reloaded.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // Readers keep the snapshot they started with
+    EXPECT_FALSE(reloaded.load());
+    EXPECT_STREQ("first", before->value("-a"));
+    EXPECT_STREQ("second", options.read()->value("-a"));
+    { auto released = std::move(before); }
+    reloading.join();
+
+    EXPECT_TRUE(reloaded.load());
+}
+
+TEST_F(ProgramOptionsTest, reload_keeps_snapshot_when_sources_are_invalid)
+{
+    auto path = WriteFile("bazpo_reload_invalid.conf", "threads = 4\n");
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    ReloadableCli options{ argc, argv, [&](Cli& cli) {
+        cli.typedOption<int>("--threads");
+        cli.source(ConfigFile::load(path));
+    } };
+    bool notified = false;
+    options.watch([&](const std::vector<std::string>&, const CliView&, const CliView&) { notified = true; });
+
+    WriteFile("bazpo_reload_invalid.conf", "threads = many\n");
+    options.requestReload();
+    auto result = options.reloadIfRequested();
+
+    EXPECT_FALSE(result.ok());
+    EXPECT_FALSE(notified);
+    EXPECT_EQ(4, options.read()->valueAs<int>("--threads"));
+    EXPECT_TRUE(options.reloadIfRequested().ok());
+}
+
+TEST_F(ProgramOptionsTest, reload_executes_option_functions_only_when_enabled)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"-a"}, {"first"} };
+    int executed = 0;
+    ReloadableCli options{ argc, argv, [&](Cli& cli) { cli.option("-a", [&](const Option&) { ++executed; }); } };
+    EXPECT_EQ(1, executed);
+
+    EXPECT_TRUE(options.reload().ok());
+    EXPECT_EQ(1, executed);
+    EXPECT_STREQ("first", options.read()->value("-a"));
+
+    options.functionsExecutedOnReload();
+    EXPECT_TRUE(options.reload().ok());
+    EXPECT_EQ(2, executed);
+}
+
+TEST_F(ProgramOptionsTest, readers_never_see_partially_reloaded_options)
+{
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    std::atomic<int> generation{ 0 };
+    ReloadableCli options{ argc, argv, [&](Cli& cli) {
+        auto value = std::to_string(generation.load());
+        cli.option("-a", "", "", value);
+        cli.option("-b", "", "", value);
+    } };
+    std::atomic<bool> stop{ false };
+    std::atomic<int> torn{ 0 };
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+        readers.emplace_back([&]() {
+            while (!stop.load())
+            {
+                auto snapshot = options.read();
+                if (std::strcmp(snapshot->value("-a"), snapshot->value("-b")) != 0)
+                    ++torn;
+            }
+        });
+    for (int i = 1; i <= 200; ++i)
+    {
+        generation.store(i);
+        options.reload();
+    }
+    stop.store(true);
+    for (auto& reader : readers)
+        reader.join();
+
+    EXPECT_EQ(0, torn.load());
+    EXPECT_STREQ("200", options.read()->value("-a"));
+}
+
+TEST_F(ProgramOptionsTest, disabled_functions_are_not_executed_after_validation)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"-a"}, {"Aoption"}, {"-n"}, {"12"} };
+    bool executed = false;
+    auto parse = [&](int limit) {
+        Cli po{ argc, argv };
+        po.option("-a", [&](const Option&) { executed = true; });
+        po.option("-n").constrain(std::make_pair(1, limit));
+        po.functionsDisabled();
+        auto result = po.tryParse();
+        EXPECT_STREQ("Aoption", po.getOption("-a").value());
+        return result;
+    };
+
+    auto invalid = parse(10);
+    ASSERT_EQ(1u, invalid.diagnostics().size());
+    EXPECT_EQ(Diagnostic::Kind::ConstraintViolation, invalid.diagnostics()[0].kind);
+    EXPECT_TRUE(parse(20).ok());
+    EXPECT_FALSE(executed);
+}
+
+TEST_F(ProgramOptionsTest, constraints_check_every_value_after_parsing)
+{
+    int argc = 7;
+    const char* argv[7]{ {"programoptions"}, {"-m"}, {"red"}, {"blue"}, {"green"}, {"-n"}, {"12"} };
+    Cli po{ argc, argv };
+    po.option("-m", "", "", "", OptionType::MultiValue).constrain({ "red", "green" });
+    po.option("-n").constrain(std::make_pair(1, 10));
+
+    auto result = po.tryParse();
+
+    ASSERT_EQ(2u, result.diagnostics().size());
+    EXPECT_EQ(Diagnostic::Kind::ConstraintViolation, result.diagnostics()[0].kind);
+    EXPECT_EQ(3, result.diagnostics()[0].argIndex);
+    EXPECT_STREQ("blue", result.diagnostics()[0].value);
+    EXPECT_EQ(6, result.diagnostics()[1].argIndex);
+}
+
+TEST_F(ProgramOptionsTest, first_constraint_violation_in_argument_order_exits)
+{
+    int argc = 5;
+    const char* argv[5]{ {"programoptions"}, {"-z"}, {"bad1"}, {"-a"}, {"bad2"} };
+    Cli po{ argc, argv };
+    po.output([](void*, const char* data, size_t size) { std::fwrite(data, 1, size, stderr); });
+    po.option("-a").constrain({ "good" });
+    po.option("-z").constrain({ "good" });
+
+    EXPECT_EXIT(po.parse(), testing::ExitedWithCode(1), "'bad1' is not expected for option -z");
+}
+
+TEST_F(ProgramOptionsTest, large_value_sets_are_checked_in_parallel_deterministically)
+{
+    std::vector<std::string> arguments{ "programoptions", "-m" };
+    for (int i = 0; i < 20000; ++i)
+        arguments.push_back(i == 15000 || i == 9000 || i == 100 ? "-5" : std::to_string(i % 50));
+    std::vector<const char*> argv;
+    for (const auto& argument : arguments)
+        argv.push_back(argument.c_str());
+    Cli po{ static_cast<int>(argv.size()), argv.data() };
+    po.callbackExecutor(std::make_shared<ParallelExecutor>(4));
+    TypedMultiOption<int> values(&po, "-m");
+    values.constrain(std::make_pair(0, 100));
+
+    auto result = po.tryParse();
+
+    ASSERT_EQ(3u, result.diagnostics().size());
+    EXPECT_EQ(102, result.diagnostics()[0].argIndex);
+    EXPECT_EQ(9002, result.diagnostics()[1].argIndex);
+    EXPECT_EQ(15002, result.diagnostics()[2].argIndex);
+    EXPECT_EQ(20000u, values.get().size());
+}
@@ -0,0 +1,196 @@
+#define BazPO_ENABLE_PARSE_TIMING
+#include "gtest/gtest.h"
+#include "../include/BazPO.hpp"
+#include "../include/BazPO/Trace.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <thread>
+
+using namespace BazPO;
+
+namespace
+{
+    class PhaseRecorder
+        : public ParseObserver
+    {
+    public:
+        virtual void phase(Phase phase, std::chrono::nanoseconds) override { phases.push_back(phase); }
+        virtual void callback(const Option&, const char* parameter, std::chrono::nanoseconds) override { callbacks.emplace_back(parameter); }
+
+        std::vector<Phase> phases;
+        std::vector<std::string> callbacks;
+    };
+
+    // Passes fixed durations to the observer instead of the measured ones
+    class FixedDurations
+        : public ParseObserver
+    {
+    public:
+        FixedDurations(ParseObserver& observer, std::map<std::string, std::chrono::nanoseconds> callbackDurations)
+            : observer(observer)
+            , callbackDurations(std::move(callbackDurations))
+        {}
+
+        virtual void phase(Phase phase, std::chrono::nanoseconds) override { observer.phase(phase, std::chrono::milliseconds(1)); }
+        virtual void callback(const Option& option, const char* parameter, std::chrono::nanoseconds) override { observer.callback(option, parameter, callbackDurations.at(parameter)); }
+
+    private:
+        ParseObserver& observer;
+        std::map<std::string, std::chrono::nanoseconds> callbackDurations;
+    };
+}
+
+TEST(ParseTimingTest, phases_are_reported_in_parse_order)
+{
+    int argc = 4;
+    const char* argv[4]{ {"programoptions"}, {"-a"}, {"1"}, {"-f"} };
+    Cli po{ argc, argv };
+    po.option("-a", [](const Option&) {});
+    po.flag("-f", [](const Option&) {});
+    po.flag("-u", [](const Option&) {});
+    PhaseRecorder recorder;
+    po.observe(recorder);
+    po.parse();
+
+    using Phase = ParseObserver::Phase;
+    EXPECT_EQ(std::vector<Phase>({ Phase::Registration, Phase::ParsePriority, Phase::ParseOptions, Phase::ApplySources, Phase::ValidateOptions,
+        Phase::CheckMandatoryOptions, Phase::CrossCheckMultiConstraints, Phase::ExecuteExistingOptions }), recorder.phases);
+    EXPECT_EQ(std::vector<std::string>({ "-a", "-f" }), recorder.callbacks);
+}
+
+TEST(ParseTimingTest, slowest_callbacks_are_reported_first)
+{
+    int argc = 4;
+    const char* argv[4]{ {"programoptions"}, {"--fast"}, {"--slow"}, {"--medium"} };
+    Cli po{ argc, argv };
+    po.flag("--fast", [](const Option&) {});
+    po.flag("--slow", [](const Option&) {});
+    po.flag("--medium", [](const Option&) {});
+    ParseTimings timings;
+    FixedDurations durations(timings, { { "--fast", std::chrono::milliseconds(1) }, { "--slow", std::chrono::milliseconds(20) }, { "--medium", std::chrono::milliseconds(5) } });
+    po.observe(durations);
+    po.parse();
+
+    auto slowest = timings.slowestCallbacks(2);
+    ASSERT_EQ(2u, slowest.size());
+    EXPECT_STREQ("--slow", slowest[0].parameter);
+    EXPECT_STREQ("--medium", slowest[1].parameter);
+    EXPECT_EQ(&po.getOption("--slow"), slowest[0].option);
+    EXPECT_EQ(std::chrono::milliseconds(20), slowest[0].duration);
+    EXPECT_EQ(3u, timings.slowestCallbacks(10).size());
+    EXPECT_EQ(std::chrono::milliseconds(1), timings.duration(ParseObserver::Phase::ExecuteExistingOptions));
+    EXPECT_EQ(std::chrono::nanoseconds(0), timings.duration(ParseObserver::Phase::ExecutePriorityOptions));
+}
+
+TEST(ParseTimingTest, subcommands_and_prioritized_options_are_timed)
+{
+    int argc = 3;
+    const char* argv[3]{ {"programoptions"}, {"build"}, {"--version"} };
+    Cli po{ argc, argv };
+    po.subcommand("build", [](Cli& build) { build.flag("--version", [](const Option&) {}).prioritize(); });
+    PhaseRecorder recorder;
+    po.observe(recorder);
+    po.parse();
+
+    ASSERT_FALSE(recorder.phases.empty());
+    EXPECT_EQ(ParseObserver::Phase::ExecutePriorityOptions, recorder.phases.back());
+    EXPECT_EQ(std::vector<std::string>({ "--version" }), recorder.callbacks);
+}
+
+TEST(ParseTimingTest, trace_events_are_written_to_the_file_of_the_environment_variable)
+{
+    auto path = testing::TempDir() + "bazpo_trace.json";
+    std::remove(path.c_str());
+    setenv("BAZPO_TEST_TRACE_FILE", path.c_str(), 1);
+    {
+        int argc = 5;
+        const char* argv[5]{ {"programoptions"}, {"-c"}, {"red"}, {"blue"}, {"-\"quoted\""} };
+        Cli po{ argc, argv };
+        po.option("-c", [](const Option&) {}, "--colors", "", "", OptionType::MultiValue).constrain({ "red", "blue" });
+        po.flag("-\"quoted\"", [](const Option&) {});
+        TraceRecorder recorder("BAZPO_TEST_TRACE_FILE");
+        ASSERT_TRUE(recorder.enabled());
+        po.observe(recorder);
+        po.parse();
+    }
+    unsetenv("BAZPO_TEST_TRACE_FILE");
+
+    std::ifstream file(path);
+    std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(0u, trace.find("{\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, trace.find("]}"));
+    EXPECT_NE(std::string::npos, trace.find("{\"name\":\"registration\",\"cat\":\"phase\",\"ph\":\"X\""));
+    EXPECT_NE(std::string::npos, trace.find("{\"name\":\"parseOptions\",\"cat\":\"phase\""));
+    EXPECT_NE(std::string::npos, trace.find("{\"name\":\"-c\",\"cat\":\"constraint\""));
+    EXPECT_NE(std::string::npos, trace.find("{\"name\":\"-c\",\"cat\":\"callback\""));
+    EXPECT_NE(std::string::npos, trace.find("\"args\":{\"values\":2}"));
+    EXPECT_NE(std::string::npos, trace.find("{\"name\":\"-\\\"quoted\\\"\",\"cat\":\"callback\""));
+    std::remove(path.c_str());
+}
+
+TEST(ParseTimingTest, trace_recorder_drops_events_beyond_capacity_and_is_disabled_without_file)
+{
+    setenv("BAZPO_TEST_TRACE_FILE", (testing::TempDir() + "bazpo_dropped_trace.json").c_str(), 1);
+    TraceRecorder recorder("BAZPO_TEST_TRACE_FILE", 2);
+    unsetenv("BAZPO_TEST_TRACE_FILE");
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.emplace_back([&recorder] { recorder.phase(ParseObserver::Phase::ParseOptions, std::chrono::microseconds(5)); });
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(2u, recorder.dropped());
+    EXPECT_TRUE(recorder.flush());
+
+    TraceRecorder disabled("BAZPO_TEST_TRACE_FILE");
+    disabled.phase(ParseObserver::Phase::ParseOptions, std::chrono::microseconds(5));
+    EXPECT_FALSE(disabled.enabled());
+    EXPECT_EQ(0u, disabled.dropped());
+}
+
+TEST(ParseTimingTest, trace_spans_keep_long_names_and_time_each_registration)
+{
+    auto path = testing::TempDir() + "bazpo_registration_trace.json";
+    std::remove(path.c_str());
+    setenv("BAZPO_TEST_TRACE_FILE", path.c_str(), 1);
+    const std::string prefix = "--" + std::string(70, 'x');
+    const std::string first = prefix + "-first", second = prefix + "-second";
+    {
+        int argc = 3;
+        const char* argv[3]{ {"programoptions"}, {first.c_str()}, {second.c_str()} };
+        TraceRecorder recorder("BAZPO_TEST_TRACE_FILE");
+        Cli po{ argc, argv };
+        po.observe(recorder);
+        po.flag(first, [](const Option&) {});
+        po.flag(second, [](const Option&) {});
+        TypedOption<int> typed(&po, "-t");
+        po.parse();
+    }
+    unsetenv("BAZPO_TEST_TRACE_FILE");
+
+    std::ifstream file(path);
+    std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_NE(std::string::npos, trace.find("{\"name\":\"" + first + "\",\"cat\":\"registration\""));
+    EXPECT_NE(std::string::npos, trace.find("{\"name\":\"" + second + "\",\"cat\":\"registration\""));
+    EXPECT_NE(std::string::npos, trace.find("{\"name\":\"-t\",\"cat\":\"registration\""));
+    EXPECT_NE(std::string::npos, trace.find("{\"name\":\"" + first + "\",\"cat\":\"callback\""));
+    EXPECT_NE(std::string::npos, trace.find("{\"name\":\"" + second + "\",\"cat\":\"callback\""));
+    std::remove(path.c_str());
+}
+
+TEST(ParseTimingTest, trace_recorder_drops_events_whose_name_does_not_fit)
+{
+    setenv("BAZPO_TEST_TRACE_FILE", (testing::TempDir() + "bazpo_unnamed_trace.json").c_str(), 1);
+    TraceRecorder recorder("BAZPO_TEST_TRACE_FILE", 2);
+    unsetenv("BAZPO_TEST_TRACE_FILE");
+    int argc = 1;
+    const char* argv[1]{ {"programoptions"} };
+    Cli po{ argc, argv };
+    const auto& option = po.flag("-f");
+    const std::string longName(100, 'x');
+
+    recorder.callback(option, longName.c_str(), std::chrono::microseconds(5));
+    recorder.callback(option, longName.c_str(), std::chrono::microseconds(5));
+    EXPECT_EQ(1u, recorder.dropped());
+}